@@ -1,5 +1,6 @@
 #pragma once
 
+#include "core/binary_codec.h"
 #include "core/bot.h"
 #include "core/exceptions.h"
 #include "core/format.h"
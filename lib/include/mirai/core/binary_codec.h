@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "export.h"
+#include "../message/sent_message.h"
+#include "../event/event.h"
+
+namespace mpp
+{
+    /// 二进制编码格式的版本号，格式发生不兼容的变化时递增
+    inline constexpr uint8_t binary_codec_version = 1;
+
+    /**
+     * \defgroup BinaryCodec
+     * \brief 消息与事件的紧凑二进制编码
+     * \remark \rst
+     * 编码结果以版本号与内容种类各一个字节开头，之后整数以 LEB128 变长整数（有符号数先经过 zigzag 变换）存储，
+     * 字符串与数组均以变长整数表示的长度作为前缀，可选值以一个字节表示是否存在。
+     * 编码结果只适合由同一版本的 Mirai++ 解码，不适合作为与其他程序交换数据的格式。
+     * 解码遇到截断、版本不符或内容种类不符的数据时会抛出 ``std::runtime_error``。
+     * \endrst
+     * \{
+     */
+
+    MPP_API void append_binary(std::string& out, const Message& message); ///< 将消息的二进制编码追加到字符串末尾
+    MPP_API void append_binary(std::string& out, const SentMessage& message); ///< 将收到或发出的消息的二进制编码追加到字符串末尾
+    MPP_API void append_binary(std::string& out, const Event& ev); ///< 将事件的二进制编码追加到字符串末尾
+
+    /// 获取消息或事件的二进制编码
+    template <typename T> requires requires(std::string& out, const T& value) { append_binary(out, value); }
+    std::string to_binary(const T& value)
+    {
+        std::string out;
+        append_binary(out, value);
+        return out;
+    }
+
+    MPP_API Message message_from_binary(std::string_view data); ///< 从二进制编码解码消息
+    MPP_API SentMessage sent_message_from_binary(std::string_view data); ///< 从二进制编码解码收到或发出的消息
+
+    /**
+     * \brief 从二进制编码解码事件
+     * \remark 解码得到的事件不关联任何 bot，需要调用事件的成员函数时应使用 Bot::decode_event
+     */
+    MPP_API Event event_from_binary(std::string_view data);
+
+    /// \}
+}
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <atomic>
 #include <filesystem>
+#include <memory>
 #include <span>
 
 #include <clu/function_ref.h>
 #include <clu/optional_ref.h>
+#include <clu/outcome.h>
 
 #include <unifex/when_all.hpp>
 #include <unifex/sequence.hpp>
@@ -19,14 +22,20 @@
 #include "info_types.h"
 #include "config_types.h"
 #include "exceptions.h"
+#include "member_roster.h"
+#include "message_store.h"
 #include "net_client.h"
+#include "roster_cache.h"
+#include "upload_cache.h"
 #include "../message/segment_types_fwd.h"
 #include "../event/event_base.h"
 #include "../event/event_types_fwd.h"
+#include "../event/shared_event.h"
 
 #include "../detail/ex_utils.h"
 #include "../detail/filter/filter_queue.h"
 #include "../detail/filter/next_event.h"
+#include "../detail/single_flight.h"
 
 namespace mpp
 {
@@ -46,10 +55,31 @@ namespace mpp
         UserId bot_id_;
         std::string sess_key_;
         detail::FilterQueue queue_;
+        detail::SingleFlight single_flight_;
+        std::atomic<std::shared_ptr<RosterCache>> roster_; // Replaced while network threads observe events
+        std::atomic<std::shared_ptr<MessageStore>> message_store_; // Replaced while network threads observe events
+        std::atomic<std::shared_ptr<UploadCache>> upload_cache_; // Replaced while uploads may be in flight
+        std::atomic<Clock::rep> ws_rtt_{ -1 };
 
         std::string check_auth_gen_body(std::string_view auth_key) const;
+        ex::task<std::string> http_get_shared_async(std::string target);
         Event parse_event(detail::JsonElem json);
         std::vector<Event> parse_events(detail::JsonElem json);
+        void observe_event(const Event& ev);
+        ex::task<void> dispatch_event_async(Event ev,
+            clu::function_ref<ex::task<void>(Event&&)> callback,
+            clu::function_ref<void()> exception_handler, clu::function_ref<void()> on_stop);
+        ex::task<void> monitor_owned_events_async(clu::function_ref<ex::task<void>(Event&&)> callback,
+            MonitorConfig config, clu::function_ref<void()> exception_handler);
+
+        template <typename T>
+        T upload_content(TargetType type, std::string_view filename, std::string_view content);
+        template <typename T>
+        ex::task<T> upload_content_async(TargetType type, std::string_view filename, std::string_view content);
+        template <typename T, typename Item>
+        ex::task<std::vector<clu::outcome<T>>> upload_batch_async(
+            TargetType type, std::span<const Item> items, size_t max_concurrency);
+        void remember_sent_message(MessageId id, const Message& message, clu::optional_param<MessageId> quote);
 
         template <typename T>
         ex::task<std::optional<T>> timeout_as_optional(
@@ -73,7 +103,7 @@ namespace mpp
          * \param port 要连接到端点的端口，默认为 8080
          */
         explicit Bot(const std::string_view host = "127.0.0.1", const std::string_view port = "8080"):
-            net_client_(host, port), queue_(get_scheduler()) {}
+            net_client_(host, port), queue_(get_scheduler()), single_flight_(get_scheduler()) {}
         ~Bot() noexcept; ///< 销毁当前 bot 对象，释放未结束的会话并关闭所有连接
         /// \}
 
@@ -89,6 +119,27 @@ namespace mpp
         std::string_view session_key() const noexcept { return sess_key_; } ///< 获取当前已授权 bot 的会话密钥
         /// \}
 
+        /// \defgroup BotTimeout
+        /// \{
+        Clock::duration request_timeout() const noexcept { return net_client_.timeout(); } ///< 获取网络请求的默认超时时长
+        /**
+         * \brief 设置网络请求与 WebSocket 连接的默认超时时长，默认为 30 秒，同步与异步操作均适用
+         * \param timeout 超时时长
+         * \remark \rst
+         * 超时的操作会抛出 ``TimeoutException``。
+         * 异步操作同样会响应 stop token 的取消请求，如使用 ``ex::stop_when`` 为单次调用设置更短的时限。
+         * \endrst
+         */
+        void set_request_timeout(const Clock::duration timeout) noexcept { net_client_.set_timeout(timeout); }
+
+        /// 获取 WebSocket 心跳最近一次测得的往返时延，尚未测得时返回空
+        std::optional<Clock::duration> websocket_rtt() const noexcept
+        {
+            if (const auto rtt = ws_rtt_.load(); rtt >= 0) return Clock::duration(rtt);
+            return std::nullopt;
+        }
+        /// \}
+
         /// \defgroup BotGetVer
         /// \{
         std::string get_version();
@@ -156,6 +207,20 @@ namespace mpp
          * \return 上传成功的图片消息段
          */
         ex::task<Image> upload_image_async(TargetType type, const std::filesystem::path& path);
+        Image upload_image_data(TargetType type, std::string_view data);
+        ex::task<Image> upload_image_data_async(TargetType type, std::string_view data); ///< 上传内存中的图片数据以获得可用于发送的图片消息段
+
+        /**
+         * \brief 并发地上传多张图片
+         * \param type 图片发送目标的类型（好友图片与群图片不通用）
+         * \param paths 图片文件的路径
+         * \param max_concurrency 同时进行的上传请求个数的上限
+         * \return 与输入顺序一致的上传结果，单张图片上传失败不会影响其他图片，失败时对应的结果中保存了异常
+         */
+        ex::task<std::vector<clu::outcome<Image>>> upload_images_async(TargetType type,
+            std::span<const std::filesystem::path> paths, size_t max_concurrency = 4);
+        ex::task<std::vector<clu::outcome<Image>>> upload_images_data_async(TargetType type,
+            std::span<const std::string_view> data, size_t max_concurrency = 4); ///< 并发地上传内存中的多张图片数据
 
         Voice upload_voice(TargetType type, const std::filesystem::path& path);
         /**
@@ -165,6 +230,29 @@ namespace mpp
          * \return 上传成功的语音消息段
          */
         ex::task<Voice> upload_voice_async(TargetType type, const std::filesystem::path& path);
+        Voice upload_voice_data(TargetType type, std::string_view data);
+        ex::task<Voice> upload_voice_data_async(TargetType type, std::string_view data); ///< 上传内存中的语音数据以获得可用于发送的语音消息段
+
+        /**
+         * \brief 并发地上传多段语音
+         * \param type 语音发送目标的类型（好友语音与群语音不通用）
+         * \param paths 语音文件的路径
+         * \param max_concurrency 同时进行的上传请求个数的上限
+         * \return 与输入顺序一致的上传结果，单段语音上传失败不会影响其他语音，失败时对应的结果中保存了异常
+         */
+        ex::task<std::vector<clu::outcome<Voice>>> upload_voices_async(TargetType type,
+            std::span<const std::filesystem::path> paths, size_t max_concurrency = 4);
+        ex::task<std::vector<clu::outcome<Voice>>> upload_voices_data_async(TargetType type,
+            std::span<const std::string_view> data, size_t max_concurrency = 4); ///< 并发地上传内存中的多段语音数据
+
+        /**
+         * \brief 启用图片与语音的上传缓存
+         * \param index_path 缓存索引文件的路径，为空时缓存仅存在于内存中
+         * \remark 启用后，内容相同的文件在同一目标类型下只会上传一次，之后直接返回之前上传得到的消息段
+         */
+        void enable_upload_cache(const std::filesystem::path& index_path = {});
+        void disable_upload_cache() noexcept { upload_cache_.store(nullptr); } ///< 禁用上传缓存
+        std::shared_ptr<UploadCache> upload_cache() const noexcept { return upload_cache_.load(); } ///< 获取上传缓存，未启用时返回空指针
         /// \}
 
         /// \defgroup BotEvent
@@ -188,9 +276,53 @@ namespace mpp
         ex::task<std::vector<Event>> peek_latest_events_async(size_t count);
 
         Event retrieve_message(MessageId id);
-        ex::task<Event> retrieve_message_async(MessageId id);
+        ex::task<Event> retrieve_message_async(MessageId id); ///< 通过消息 id 获取收到的消息事件，启用消息存储时优先从本地获取
+        SentMessage retrieve_message_content(MessageId id);
+        ex::task<SentMessage> retrieve_message_content_async(MessageId id); ///< 通过消息 id 获取收到或发出的消息内容，启用消息存储时优先从本地获取
         size_t count_message();
         ex::task<size_t> count_message_async();
+
+        /**
+         * \brief 解码由 to_binary 编码的事件，并将其关联到当前 bot
+         * \param data 事件的二进制编码
+         * \return 解码得到的事件，可以像收到的事件一样调用其成员函数
+         */
+        Event decode_event(std::string_view data);
+        /// \}
+
+        /// \defgroup BotMsgStore
+        /// \{
+        /**
+         * \brief 启用最近收到和发出的消息的本地存储
+         * \param capacity 最多存储的消息条数
+         * \param byte_budget 所有消息估计占用的内存上限，单位为字节
+         * \remark \rst
+         * 启用后，监听或获取到的消息事件与通过 ``send_message`` 发出的消息都会被存入本地，
+         * ``retrieve_message`` 与 ``retrieve_message_content`` 仅在本地不存在对应消息时才会请求 mirai-api-http。
+         * \endrst
+         */
+        void enable_message_store(size_t capacity = 4096, size_t byte_budget = 16 * 1024 * 1024);
+        void disable_message_store() noexcept { message_store_.store(nullptr); } ///< 禁用并清空消息存储
+        std::shared_ptr<MessageStore> message_store() const noexcept { return message_store_.load(); } ///< 获取消息存储，未启用时返回空指针
+        /// \}
+
+        /// \defgroup BotRoster
+        /// \{
+        /**
+         * \brief 启用好友、群与群成员列表的本地缓存
+         * \param max_age 缓存数据的最长有效时间，默认永不过期
+         * \remark \rst
+         * 启用后，``list_friends``，``list_groups``，``list_members`` 与 ``get_member_info``
+         * 会优先使用缓存中的数据，并在缓存无效时重新获取并填充缓存。
+         * 缓存会根据监听或获取到的事件（成员加群、退群、改名片等）进行增量更新。
+         * 应在开始监听事件之前调用此函数。
+         * \endrst
+         */
+        void enable_roster_cache(Clock::duration max_age = Clock::duration::max());
+        void disable_roster_cache() noexcept { roster_.store(nullptr); } ///< 禁用并清空本地缓存
+        std::shared_ptr<RosterCache> roster_cache() const noexcept { return roster_.load(); } ///< 获取本地缓存，未启用时返回空指针
+        void refresh_roster();
+        ex::task<void> refresh_roster_async(); ///< 清空本地缓存并重新获取好友与群列表，群成员列表将在下次使用时重新获取
         /// \}
 
         std::vector<Friend> list_friends();
@@ -199,6 +331,8 @@ namespace mpp
         ex::task<std::vector<Group>> list_groups_async();
         std::vector<Member> list_members(GroupId id);
         ex::task<std::vector<Member>> list_members_async(GroupId id);
+        MemberRoster get_member_roster(GroupId id);
+        ex::task<MemberRoster> get_member_roster_async(GroupId id); ///< 以紧凑的形式获取群成员列表，适合人数较多的群
 
         void mute(GroupId group, UserId user, std::chrono::seconds duration);
         ex::task<void> mute_async(GroupId group, UserId user, std::chrono::seconds duration);
@@ -249,6 +383,15 @@ namespace mpp
         void monitor_events(clu::function_ref<bool(const Event&)> callback,
             clu::function_ref<void()> exception_handler = log_exception);
 
+        /**
+         * \brief 启动 Websocket 会话，只监听指定通道的消息或事件
+         * \param callback 接收到消息时需要调用的函数
+         * \param channel 监听的通道，同步监听不支持 MonitorChannel::separate
+         * \param exception_handler callback 抛出未处理的异常时调用的函数，默认为 log_exception
+         */
+        void monitor_events(clu::function_ref<bool(const Event&)> callback, MonitorChannel channel,
+            clu::function_ref<void()> exception_handler = log_exception);
+
         // TODO: should be an on/off thing instead of this?
         /**
          * \brief 异步地启动 Websocket 会话，监听所有种类的事件
@@ -262,6 +405,96 @@ namespace mpp
          */
         ex::task<void> monitor_events_async(clu::function_ref<ex::task<void>(const Event&)> callback,
             clu::function_ref<void()> exception_handler = log_exception);
+
+        /**
+         * \brief 异步地启动 Websocket 会话，监听所有种类的事件，并在连接断开时自动重连
+         * \param callback 接收到消息时需要调用的函数
+         * \param config 监听的配置
+         * \param exception_handler callback 抛出未处理的异常时调用的函数，默认为 log_exception
+         * \remark \rst
+         * 连接意外断开后，会等待一段随机化的退避时长，检查当前会话仍然有效后重新连接，
+         * 并通过 ``/fetchMessage`` 补齐断线期间的消息和事件，已经分发过的消息不会被重复分发。
+         * 重连期间正在等待的 ``next_event_async`` 不会被取消。若会话已失效，则抛出对应的 ``MiraiException``。
+         * 通过 ``config.channel`` 可以只接收消息或事件，或者通过两个相互独立的连接分别接收消息和事件。
+         * \endrst
+         */
+        ex::task<void> monitor_events_async(clu::function_ref<ex::task<void>(const Event&)> callback,
+            MonitorConfig config, clu::function_ref<void()> exception_handler = log_exception);
+
+        /**
+         * \brief 异步地启动 Websocket 会话，以共享所有权的形式分发接收到的消息和事件
+         * \param callback 接收到消息时需要调用的函数
+         * \param config 监听的配置
+         * \param exception_handler callback 抛出未处理的异常时调用的函数，默认为 log_exception
+         * \remark \rst
+         * 与 ``monitor_events_async`` 相同，但回调函数收到的是 ``SharedEvent``，
+         * 可以不经复制地将同一个事件交给多个处理函数，或在回调函数返回后继续持有该事件。
+         * \endrst
+         */
+        ex::task<void> monitor_shared_events_async(clu::function_ref<ex::task<void>(SharedEvent)> callback,
+            MonitorConfig config = {}, clu::function_ref<void()> exception_handler = log_exception);
+
+        /**
+         * \brief 异步地通过 HTTP 轮询接收消息和事件，适用于无法使用 WebSocket 的环境
+         * \param callback 接收到消息时需要调用的函数
+         * \param config 轮询的配置
+         * \param exception_handler callback 抛出未处理的异常时调用的函数，默认为 log_exception
+         * \remark \rst
+         * 回调函数与 ``monitor_events_async`` 相同，收到的事件同样会唤醒正在等待的 ``next_event_async``。
+         * 获取到满额的一批消息时会立即再次请求，否则请求间隔随消息频率在配置的上下限之间自动调整。
+         * 回调函数在后台执行，因此处理当前一批消息的同时就会开始获取下一批消息。
+         * \endrst
+         */
+        ex::task<void> poll_events_async(clu::function_ref<ex::task<void>(const Event&)> callback,
+            PollConfig config = {}, clu::function_ref<void()> exception_handler = log_exception);
+
+        /**
+         * \brief 异步地启动内置的 HTTP 服务器，接收 mirai-api-http webhook 适配器推送的消息和事件
+         * \param address 监听的地址
+         * \param port 监听的端口
+         * \param callback 接收到消息时需要调用的函数
+         * \param exception_handler callback 抛出未处理的异常时调用的函数，默认为 log_exception
+         * \remark \rst
+         * 回调函数与 ``monitor_events_async`` 相同，收到的事件同样会唤醒正在等待的 ``next_event_async``。
+         * 每个 POST 请求的请求体可以是单个事件，也可以是由多个事件组成的数组，连接在请求之间保持打开。
+         * \endrst
+         */
+        ex::task<void> monitor_webhook_async(std::string_view address, uint16_t port,
+            clu::function_ref<ex::task<void>(const Event&)> callback,
+            clu::function_ref<void()> exception_handler = log_exception);
+
+        /**
+         * \brief 异步地启动 Websocket 会话，将接收到的消息和事件攒成批后统一处理
+         * \param callback 接收到一批消息时需要调用的函数
+         * \param batch 攒批的配置
+         * \param config 监听的配置
+         * \param exception_handler callback 抛出未处理的异常时调用的函数，默认为 log_exception
+         * \remark \rst
+         * 事件个数达到 ``batch.max_size``，或者距上次分发超过 ``batch.max_delay`` 时，
+         * 已收到的事件会按接收顺序交给回调函数。回调函数不会被并发调用，每批事件至少包含一个事件。
+         * 回调函数发出取消信号时停止监听，监听结束时尚未分发的事件会作为最后一批分发。
+         * \endrst
+         */
+        ex::task<void> monitor_event_batches_async(clu::function_ref<ex::task<void>(std::span<const Event>)> callback,
+            BatchConfig batch = {}, MonitorConfig config = {}, clu::function_ref<void()> exception_handler = log_exception);
+
+        /**
+         * \brief 异步地回放通过 MonitorConfig::record_path 录制的 WebSocket 帧
+         * \param record_path 录制文件的路径
+         * \param callback 分发事件时需要调用的函数
+         * \param config 回放的配置
+         * \param exception_handler callback 抛出未处理的异常时调用的函数，默认为 log_exception
+         * \remark \rst
+         * 录制的每一帧都会像从 WebSocket 收到时一样经过 ``parse_event`` 与过滤队列后交给回调函数，
+         * 因此正在等待的 ``next_event_async`` 同样会被唤醒，已启用的消息存储与成员列表缓存也会被更新。
+         * 按录制速度回放时，事件之间的间隔与录制时相同。所有事件都处理完毕后返回，便于离线测量处理函数的吞吐量。
+         * 同时处理中的事件达到 ``ReplayConfig::max_in_flight`` 时暂停读取；回放被取消或回调函数请求停止后不再读取之后的帧。
+         * 回放本身不访问 mirai-api-http，但在回调中调用事件的成员函数（如回复消息）仍会向当前会话发送请求。
+         * \endrst
+         */
+        ex::task<void> replay_events_async(const std::filesystem::path& record_path,
+            clu::function_ref<ex::task<void>(const Event&)> callback,
+            ReplayConfig config = {}, clu::function_ref<void()> exception_handler = log_exception);
         /// \}
 
         SessionConfig get_config();
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <chrono>
+#include <filesystem>
 #include <optional>
 
 #include "../detail/json_fwd.h"
@@ -27,6 +29,53 @@ namespace mpp
         void format_as_json(fmt::format_context& ctx) const;
     };
 
+    /// WebSocket 监听的通道
+    enum class MonitorChannel : uint8_t
+    {
+        all, ///< 通过一个连接接收所有消息和事件
+        message, ///< 只接收消息
+        event, ///< 只接收除消息外的事件
+        separate ///< 通过两个独立的连接分别接收消息和事件
+    };
+
+    /// WebSocket 事件监听的配置
+    struct MonitorConfig final
+    {
+        MonitorChannel channel = MonitorChannel::all; ///< 监听的通道
+        bool auto_reconnect = true; ///< 连接断开时是否自动重连
+        std::chrono::milliseconds initial_backoff{ 500 }; ///< 首次重连前等待的时长
+        std::chrono::milliseconds max_backoff{ 30000 }; ///< 重连前等待时长的上限，每次重连失败后等待时长翻倍
+        size_t max_reconnect_attempts = 0; ///< 连续重连失败次数的上限，为 0 时不限制
+        bool backfill = true; ///< 重连后是否通过 /fetchMessage 补齐断线期间未收到的消息和事件
+        size_t backfill_batch = 64; ///< 补齐消息时每次请求获取的消息个数
+        size_t dedupe_window = 1024; ///< 用于去除重复消息的已分发消息记录个数
+        std::chrono::milliseconds heartbeat_interval{ 10000 }; ///< 发送 WebSocket ping 的间隔，为 0 时不发送
+        std::chrono::milliseconds heartbeat_timeout{ 30000 }; ///< 超过该时长未收到任何数据时认为连接已断开，必须大于 heartbeat_interval
+        std::filesystem::path record_path; ///< 若不为空，收到的每个 WebSocket 帧都会连同接收时间追加写入该文件，供 replay_events_async 回放
+    };
+
+    /// 轮询事件的配置
+    struct PollConfig final
+    {
+        size_t batch_size = 64; ///< 每次请求获取的消息个数
+        std::chrono::milliseconds min_interval{ 50 }; ///< 两次请求之间间隔的下限
+        std::chrono::milliseconds max_interval{ 2000 }; ///< 两次请求之间间隔的上限
+    };
+
+    /// 回放录制事件的配置
+    struct ReplayConfig final
+    {
+        double speed = 1.0; ///< 回放速度相对于录制时的倍数，为 0 时不等待，尽快分发所有事件
+        size_t max_in_flight = 64; ///< 同时处理中的事件个数的上限，达到上限时暂停读取，直到有事件处理完毕
+    };
+
+    /// 批量分发事件的配置
+    struct BatchConfig final
+    {
+        size_t max_size = 64; ///< 每批事件个数的上限，攒满时立即分发
+        std::chrono::microseconds max_delay{ 10000 }; ///< 事件在分发前等待的时长上限
+    };
+
     struct MemberInfo final
     {
         std::optional<std::string> name;
@@ -65,5 +65,14 @@ namespace mpp
     };
     MPP_RESTORE_EXPORT_WARNING
 
+    MPP_SUPPRESS_EXPORT_WARNING
+    /// 网络操作超时异常类
+    class MPP_API TimeoutException : public std::runtime_error
+    {
+    public:
+        TimeoutException(): runtime_error("网络操作超时") {} ///< 构建超时异常
+    };
+    MPP_RESTORE_EXPORT_WARNING
+
     MPP_API void log_exception(); ///< 将当前捕获到的异常信息输出到 stderr
 }
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <optional>
+#include <ranges>
+#include <string>
+#include <vector>
+
+#include "info_types.h"
+
+namespace mpp
+{
+    /// 群成员列表中单个成员的视图，其中的名称引用所属的 MemberRoster
+    struct MemberView final
+    {
+        UserId id;
+        std::string_view name;
+        Permission permission{};
+    };
+
+    MPP_SUPPRESS_EXPORT_WARNING
+    /**
+     * \brief 紧凑存储的群成员列表
+     * \remark \rst
+     * 与 ``std::vector<Member>`` 不同，所有成员共享同一份群信息，成员名称存放于同一块连续的字符串存储中，
+     * 适合人数较多的群。支持按 ``UserId`` 查找与按名称前缀查找。
+     * \endrst
+     */
+    class MPP_API MemberRoster final
+    {
+    private:
+        Group group_;
+        std::vector<UserId> ids_;
+        std::vector<Permission> permissions_;
+        std::vector<uint32_t> name_offsets_; // The name of the i-th member is names_[name_offsets_[i], name_offsets_[i + 1])
+        std::string names_;
+        std::vector<uint32_t> by_id_; // Member indices sorted by id
+        std::vector<uint32_t> by_name_; // Member indices sorted by name
+
+        std::string_view name_at(size_t index) const noexcept
+        {
+            return std::string_view(names_).substr(name_offsets_[index], name_offsets_[index + 1] - name_offsets_[index]);
+        }
+
+        void build_indices();
+
+    public:
+        MemberRoster() = default; ///< 创建一个空的成员列表
+        explicit MemberRoster(Group group): group_(std::move(group)) {} ///< 创建一个所属群为 group 的空成员列表
+        explicit MemberRoster(const std::vector<Member>& members); ///< 从成员列表构建
+
+        const Group& group() const noexcept { return group_; } ///< 获取所属的群
+        size_t size() const noexcept { return ids_.size(); } ///< 获取成员数量
+        [[nodiscard]] bool empty() const noexcept { return ids_.empty(); } ///< 判断成员列表是否为空
+
+        /// 获取第 index 个成员
+        MemberView operator[](const size_t index) const noexcept
+        {
+            return { ids_[index], name_at(index), permissions_[index] };
+        }
+
+        /// 获取所有成员的视图
+        auto members() const
+        {
+            return std::views::iota(size_t{}, size())
+                | std::views::transform([this](const size_t i) { return (*this)[i]; });
+        }
+
+        std::optional<MemberView> find(UserId id) const noexcept; ///< 按 id 查找成员，不存在时返回空
+        std::vector<MemberView> find_by_name_prefix(std::string_view prefix) const; ///< 查找名称以 prefix 开头的所有成员，结果按名称排序
+
+        Member to_member(size_t index) const; ///< 将第 index 个成员转换为完整的 Member 对象
+        std::vector<Member> to_members() const; ///< 转换为完整的 Member 列表
+
+        /// 从 mirai-api-http 返回的成员列表 JSON 数组构建
+        static MemberRoster from_json(detail::JsonElem json);
+    };
+    MPP_RESTORE_EXPORT_WARNING
+}
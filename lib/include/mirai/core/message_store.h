@@ -0,0 +1,77 @@
+#pragma once
+
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "../event/event.h"
+#include "../message/sent_message.h"
+
+namespace mpp
+{
+    MPP_SUPPRESS_EXPORT_WARNING
+    /**
+     * \brief 最近收到和发出的消息的本地存储，以消息 id 为键
+     * \remark \rst
+     * 消息存放于固定容量的环形缓冲区中，当消息条数超过容量或估计占用的内存超过预算时，
+     * 最早存入的消息会被丢弃。所有操作均为线程安全的。
+     * \endrst
+     */
+    class MPP_API MessageStore final
+    {
+    private:
+        struct Slot
+        {
+            MessageId id;
+            std::variant<Event, SentMessage> entry; // A received message event, or a message sent by this bot
+            size_t bytes = 0;
+        };
+
+        mutable std::mutex mutex_;
+        std::vector<std::optional<Slot>> slots_;
+        size_t byte_budget_ = 0;
+        size_t bytes_ = 0;
+        size_t oldest_ = 0;
+        size_t count_ = 0;
+        std::unordered_map<MessageId, size_t> index_;
+
+        void insert(MessageId id, std::variant<Event, SentMessage>&& entry, size_t bytes);
+        void evict_oldest();
+
+    public:
+        /**
+         * \brief 创建一个消息存储
+         * \param capacity 最多存储的消息条数
+         * \param byte_budget 所有消息估计占用的内存上限，单位为字节
+         */
+        explicit MessageStore(size_t capacity = 4096, size_t byte_budget = 16 * 1024 * 1024);
+
+        size_t capacity() const noexcept { return slots_.size(); } ///< 获取最多存储的消息条数
+        size_t byte_budget() const noexcept { return byte_budget_; } ///< 获取内存预算
+        size_t size() const; ///< 获取当前存储的消息条数
+        size_t bytes() const; ///< 获取当前存储的消息估计占用的内存
+
+        /**
+         * \brief 存储一个消息事件，非消息事件将被忽略
+         * \param ev 收到的事件
+         */
+        void add(const Event& ev);
+
+        /**
+         * \brief 存储一条本机器人发出的消息
+         * \param id 发送消息后得到的消息 id
+         * \param message 消息内容
+         * \param quote 引用回复的消息 id，若该消息也在存储中则会一并记录引用内容
+         */
+        void add_sent(MessageId id, const Message& message, std::optional<MessageId> quote = std::nullopt);
+
+        std::optional<Event> find_event(MessageId id) const; ///< 查找收到的消息事件，不存在时返回空
+        std::optional<SentMessage> find_message(MessageId id) const; ///< 查找收到或发出的消息，不存在时返回空
+        bool contains(MessageId id) const; ///< 判断存储中是否有某条消息
+
+        void clear(); ///< 清空存储
+    };
+    MPP_RESTORE_EXPORT_WARNING
+}
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <functional>
 #include <memory>
+#include <optional>
+#include <span>
 #include <string_view>
 #include <chrono>
 #include <unifex/task.hpp>
@@ -20,6 +23,7 @@ namespace mpp::net
     using Duration = Clock::duration;
 
     class WebsocketSession;
+    class WebhookServer;
 
     MPP_SUPPRESS_EXPORT_WARNING
     class MPP_API Client final
@@ -62,12 +66,27 @@ namespace mpp::net
 
         std::string_view host() const noexcept;
 
+        Duration timeout() const noexcept; ///< 获取网络操作的默认超时时长
+        void set_timeout(Duration timeout) noexcept; ///< 设置网络操作的默认超时时长
+
         std::string http_get(std::string_view target);
         ex::task<std::string> http_get_async(std::string_view target);
+        ex::task<std::string> http_get_async(std::string_view target, Duration timeout);
         std::string http_post(std::string_view target, std::string_view content_type, std::string body);
         ex::task<std::string> http_post_async(std::string_view target, std::string_view content_type, std::string body);
+        ex::task<std::string> http_post_async(std::string_view target, std::string_view content_type, std::string body,
+            Duration timeout);
+        /**
+         * \brief 发送由多段内存组成请求体的 POST 请求，各段内存按顺序直接写入套接字而不会被拼接
+         * \remark 请求完成之前，body 中各段引用的内存需保持有效
+         */
+        std::string http_post_parts(std::string_view target, std::string_view content_type,
+            std::span<const std::string_view> body);
+        ex::task<std::string> http_post_parts_async(std::string_view target, std::string_view content_type,
+            std::span<const std::string_view> body);
         std::string http_post_json(std::string_view target, std::string body);
         ex::task<std::string> http_post_json_async(std::string_view target, std::string body);
+        ex::task<std::string> http_post_json_async(std::string_view target, std::string body, Duration timeout);
 
         ex::task<void> schedule();
         ex::task<void> wait_async(TimePoint tp);
@@ -75,6 +94,9 @@ namespace mpp::net
         WebsocketSession new_websocket_session();
         void connect_websocket(WebsocketSession& ws, std::string_view target);
         ex::task<void> connect_websocket_async(WebsocketSession& ws, std::string_view target);
+        ex::task<void> connect_websocket_async(WebsocketSession& ws, std::string_view target, Duration timeout);
+
+        WebhookServer new_webhook_server(std::string_view address, uint16_t port);
 
         Impl* pimpl_ptr() const { return impl_.get(); }
     };
@@ -95,10 +117,50 @@ namespace mpp::net
 
         std::string read();
         ex::task<std::string> read_async();
+
+        /**
+         * \brief 启动心跳，每隔一段时间发送一次 ping 并根据收到的 pong 计算往返时延，需在连接建立后调用
+         * \param interval 发送 ping 的间隔
+         * \param timeout 若超过该时长未收到任何数据（包括 pong），则认为连接已断开，正在进行的读取会抛出 TimeoutException，
+         *                必须大于 interval
+         * \param on_pong 每次收到 pong 时以测得的往返时延调用的函数
+         */
+        void start_heartbeat(Duration interval, Duration timeout, std::function<void(Duration)> on_pong = {});
+        std::optional<Duration> rtt() const noexcept; ///< 获取最近一次测得的往返时延，尚未测得时返回空
         void close();
         ex::task<void> close_async();
 
         Impl* pimpl_ptr() const noexcept { return impl_.get(); }
     };
+
+    /// 接收 HTTP POST 推送的简单服务器，支持持久连接
+    class MPP_API WebhookServer final
+    {
+    public:
+        /// 处理一个请求体的函数，抛出异常时服务器以 400 状态码回应
+        using Handler = std::function<void(std::string body)>;
+
+    private:
+        class Impl;
+        std::unique_ptr<Impl> impl_;
+
+    public:
+        WebhookServer(boost::asio::io_context& ctx, std::string_view address, uint16_t port);
+        ~WebhookServer() noexcept;
+        WebhookServer(const WebhookServer&) = delete;
+        WebhookServer(WebhookServer&&) noexcept;
+        WebhookServer& operator=(const WebhookServer&) = delete;
+        WebhookServer& operator=(WebhookServer&&) noexcept;
+
+        uint16_t port() const noexcept; ///< 获取实际监听的端口
+
+        /**
+         * \brief 异步地接受连接并处理请求，直到被取消或调用 close
+         * \param handler 对每个 POST 请求调用的函数，可能在多个线程上同时被调用，服务结束后不会再被调用
+         * \remark 服务结束时会关闭所有仍然打开的连接，并等待它们的处理结束后才返回
+         */
+        ex::task<void> serve_async(Handler handler);
+        void close(); ///< 停止接受新的连接，使 serve_async 结束
+    };
     MPP_RESTORE_EXPORT_WARNING
 }
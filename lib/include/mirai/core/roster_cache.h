@@ -0,0 +1,116 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "info_types.h"
+#include "config_types.h"
+#include "../event/event.h"
+
+namespace mpp
+{
+    MPP_SUPPRESS_EXPORT_WARNING
+    /// 好友、群与群成员列表的本地缓存，首次获取后根据收到的事件进行增量更新
+    class MPP_API RosterCache final
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+    private:
+        using TimePoint = Clock::time_point;
+
+        struct CachedMemberInfo
+        {
+            MemberInfo info;
+            TimePoint fetched;
+        };
+
+        struct GroupEntry
+        {
+            Group group;
+            std::unordered_map<UserId, Member> members;
+            std::optional<TimePoint> members_fetched;
+            std::unordered_map<UserId, CachedMemberInfo> member_infos;
+        };
+
+        mutable std::mutex mutex_;
+        Clock::duration max_age_;
+        std::unordered_map<UserId, Friend> friends_;
+        std::optional<TimePoint> friends_fetched_;
+        std::unordered_map<GroupId, GroupEntry> groups_;
+        std::optional<TimePoint> groups_fetched_;
+
+        // Events received while a full list is being fetched, replayed on top of the fetched list
+        size_t active_fetches_ = 0;
+        uint64_t next_seq_ = 0;
+        std::vector<std::pair<uint64_t, Event>> journal_;
+
+        bool is_fresh(std::optional<TimePoint> fetched) const noexcept;
+        const GroupEntry* find_fresh_members(GroupId group) const;
+        void update_member(const Member& member);
+        void remove_member(const Member& member);
+        void apply(const Event& ev);
+        void replay_since(uint64_t seq);
+        void end_fetch() noexcept;
+
+    public:
+        /**
+         * \brief 一次完整列表的获取过程
+         * \remark \rst
+         * 在发出请求之前通过 ``begin_fetch`` 创建，并在收到结果后传给 ``set_friends`` 等函数。
+         * 获取期间收到的事件会在填充缓存后重新应用，因此较新的增量更新不会被较旧的完整列表覆盖。
+         * \endrst
+         */
+        class MPP_API Fetch final
+        {
+        private:
+            friend class RosterCache;
+            RosterCache* cache_ = nullptr;
+            uint64_t seq_ = 0;
+            Fetch(RosterCache* cache, const uint64_t seq) noexcept: cache_(cache), seq_(seq) {}
+
+        public:
+            Fetch(Fetch&& other) noexcept: cache_(std::exchange(other.cache_, nullptr)), seq_(other.seq_) {}
+            Fetch& operator=(Fetch&&) = delete;
+            ~Fetch() noexcept { if (cache_) cache_->end_fetch(); }
+        };
+
+        /**
+         * \brief 创建一个空的缓存
+         * \param max_age 缓存数据的最长有效时间，超过该时间的数据需要重新获取，默认永不过期
+         */
+        explicit RosterCache(const Clock::duration max_age = Clock::duration::max()): max_age_(max_age) {}
+
+        Clock::duration max_age() const noexcept { return max_age_; } ///< 获取缓存数据的最长有效时间
+
+        std::optional<std::vector<Friend>> friends() const; ///< 获取缓存的好友列表，缓存无效时返回空
+        std::optional<std::vector<Group>> groups() const; ///< 获取缓存的群列表，缓存无效时返回空
+        std::optional<std::vector<Member>> members(GroupId group) const; ///< 获取缓存的群成员列表，缓存无效时返回空
+
+        /// \defgroup RosterFind
+        /// \{
+        std::optional<Friend> find_friend(UserId id) const;
+        std::optional<Group> find_group(GroupId id) const;
+        std::optional<Member> find_member(GroupId group, UserId user) const;
+        /**
+         * \brief 在缓存中查找对应的好友、群、群成员或群成员资料
+         * \return 对应的信息，若缓存无效或不存在该对象则返回空
+         */
+        std::optional<MemberInfo> find_member_info(GroupId group, UserId user) const;
+        /// \}
+
+        [[nodiscard]] Fetch begin_fetch(); ///< 在请求完整列表之前调用，开始记录获取期间收到的事件
+        void set_friends(const std::vector<Friend>& friends, const Fetch& fetch); ///< 用完整的好友列表填充缓存
+        void set_groups(const std::vector<Group>& groups, const Fetch& fetch); ///< 用完整的群列表填充缓存
+        void set_members(GroupId group, const std::vector<Member>& members, const Fetch& fetch); ///< 用完整的群成员列表填充缓存
+        void set_member_info(GroupId group, UserId user, const MemberInfo& info, const Fetch& fetch); ///< 缓存群成员资料
+
+        void update(const Event& ev); ///< 根据收到的事件增量更新缓存
+        void invalidate(); ///< 使所有缓存数据失效
+    };
+    MPP_RESTORE_EXPORT_WARNING
+}
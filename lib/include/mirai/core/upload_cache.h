@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+#include "common.h"
+#include "../message/segment_types.h"
+
+namespace mpp
+{
+    MPP_SUPPRESS_EXPORT_WARNING
+    /**
+     * \brief 以文件内容为键的图片与语音上传缓存
+     * \remark \rst
+     * 键由文件内容的 64 位 FNV-1a 哈希值、文件大小、上传目标类型以及上传的是图片还是语音组成，
+     * 内容相同的文件只需上传一次。每个缓存项还记录了内容的 SHA-256 摘要，命中时会再次比较摘要，
+     * 因此键的哈希冲突不会返回其他文件的上传结果。若指定了索引文件，缓存项会被追加写入该文件，
+     * 并在下次创建缓存时重新载入。
+     * \endrst
+     */
+    class MPP_API UploadCache final
+    {
+    private:
+        enum class Kind : uint8_t { image, voice };
+
+        struct Key
+        {
+            uint64_t hash = 0;
+            uint64_t size = 0;
+            TargetType type{};
+            Kind kind{};
+
+            bool operator==(const Key&) const noexcept = default;
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const noexcept;
+        };
+
+        struct Entry
+        {
+            std::array<uint8_t, 32> digest{}; // SHA-256 of the content
+            std::string id;
+            std::optional<std::string> url;
+        };
+
+        mutable std::mutex mutex_;
+        std::unordered_map<Key, Entry, KeyHash> entries_;
+        std::ofstream index_;
+
+        static Key make_key(Kind kind, TargetType type, std::string_view content) noexcept;
+        std::optional<Entry> find(const Key& key, std::string_view content) const;
+        void add(const Key& key, Entry entry);
+        void load_index(const std::filesystem::path& index_path);
+
+    public:
+        UploadCache() = default; ///< 创建一个仅存在于内存中的缓存
+
+        /**
+         * \brief 创建一个带有持久化索引的缓存
+         * \param index_path 索引文件的路径，若文件已存在则载入其中的缓存项
+         */
+        explicit UploadCache(const std::filesystem::path& index_path);
+
+        std::optional<Image> find_image(TargetType type, std::string_view content) const; ///< 查找内容相同的已上传图片
+        std::optional<Voice> find_voice(TargetType type, std::string_view content) const; ///< 查找内容相同的已上传语音
+        void add_image(TargetType type, std::string_view content, const Image& image); ///< 记录一张已上传的图片
+        void add_voice(TargetType type, std::string_view content, const Voice& voice); ///< 记录一段已上传的语音
+
+        size_t size() const; ///< 获取缓存项的个数
+        void clear(); ///< 清空内存中的缓存项，索引文件不受影响
+
+        static uint64_t content_hash(std::string_view content) noexcept; ///< 计算内容的 64 位 FNV-1a 哈希值
+    };
+    MPP_RESTORE_EXPORT_WARNING
+}
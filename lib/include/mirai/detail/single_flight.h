@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <clu/function_ref.h>
+#include <clu/outcome.h>
+#include <unifex/inplace_stop_token.hpp>
+
+#include "../core/net_client.h"
+
+namespace mpp::detail
+{
+    namespace ex = unifex;
+
+    // Coalesces identical concurrent read-only requests into a single in-flight one
+    MPP_SUPPRESS_EXPORT_WARNING
+    class MPP_API SingleFlight final
+    {
+    private:
+        struct Flight;
+
+        struct Waiter
+        {
+            Flight* flight = nullptr; // Reset by the leader when it takes the waiter off the list
+            Waiter* next = nullptr;
+            std::coroutine_handle<> handle;
+            clu::outcome<std::string> result;
+            bool done = false; // Completes without a result, either cancelled or the request was
+            std::atomic_bool suspended = false; // Whichever of the suspension and the completion comes second resumes
+
+            bool await_ready() const noexcept { return false; }
+            bool await_suspend(std::coroutine_handle<> hdl) noexcept;
+            void await_resume() const noexcept {}
+        };
+
+        struct Flight
+        {
+            Waiter* waiters = nullptr;
+            bool leader_cancelled = false;
+            ex::inplace_stop_source stop; // Cancels the request once nobody is interested in the result
+        };
+
+        net::Client::Scheduler sch_;
+        std::mutex mutex_;
+        std::unordered_map<std::string, Flight*> flights_; // Key -> the flight, which lives in the leader's frame
+
+        void complete(Waiter& waiter);
+        void leave(const std::string& key, Waiter& waiter);
+        void abandon_if_unused(const std::string& key, Flight& flight);
+
+    public:
+        explicit SingleFlight(const net::Client::Scheduler sch): sch_(sch) {}
+
+        // Only the first caller with a certain key invokes the request,
+        // other callers with the same key wait for the result of that one.
+        // A cancelled waiter leaves right away, while the request itself is only cancelled
+        // when the first caller is cancelled and no other caller is waiting anymore
+        ex::task<std::string> run(std::string key, clu::function_ref<ex::task<std::string>()> request);
+    };
+    MPP_RESTORE_EXPORT_WARNING
+}
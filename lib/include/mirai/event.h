@@ -1,3 +1,6 @@
 #pragma once
 
+#include "event/command_dispatcher.h"
+#include "event/event_router.h"
 #include "event/event_types.h"
+#include "event/shared_event.h"
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <vector>
+#include <unifex/task.hpp>
+
+#include "event.h"
+#include "../message/command_trie.h"
+#include "../message/message_tokenizer.h"
+
+namespace mpp
+{
+    namespace ex = unifex;
+
+    /// 命令的参数
+    struct CommandArgs final
+    {
+        std::string_view command; ///< 匹配到的命令词
+        std::string_view text; ///< 第一个消息段中命令词之后的文本，已去除开头的空白字符
+        std::span<const Segment> rest; ///< 第一个消息段之后的其余消息段
+
+        /// 将参数切分为词，结果直接指向原消息
+        MessageTokenizer tokens(const TokenizerOptions options = {}) const noexcept { return { text, rest, options }; }
+    };
+
+    MPP_SUPPRESS_EXPORT_WARNING
+    /**
+     * \brief 根据消息开头的命令词分发消息事件
+     * \remark \rst
+     * 所有命令词及其别名被编入同一棵基数树 ``CommandTrie`` 中，每条消息只需沿树匹配一次开头的文本，
+     * 耗时与命令词长度成正比而与命令个数无关。有多个命令词匹配时选择最长的一个。
+     * 分发器可以直接作为 ``monitor_events_async`` 或 ``EventRouter`` 的处理函数使用。
+     * 注册与分发可以在不同线程上同时进行。
+     * \endrst
+     */
+    class MPP_API CommandDispatcher final
+    {
+    public:
+        using Handler = std::function<ex::task<void>(const Event&, CommandArgs)>; ///< 命令处理函数
+
+    private:
+        struct Slot
+        {
+            std::shared_ptr<const Handler> handler;
+            size_t aliases = 0; // Number of command words referring to this slot
+        };
+
+        mutable std::shared_mutex mutex_;
+        CommandTrie trie_;
+        std::vector<Slot> slots_;
+        std::vector<size_t> free_slots_;
+
+        void release(size_t index);
+
+    public:
+        /**
+         * \brief 注册一个命令，若命令词已被注册则替换原有的处理函数
+         * \param names 命令词及其别名
+         * \param handler 处理函数
+         * \remark 任一命令词为空或包含空白字符时抛出 std::invalid_argument，此时不会注册其中任何一个命令词
+         */
+        void add(std::initializer_list<std::string_view> names, Handler handler);
+        void add(const std::string_view name, Handler handler) { add({ name }, std::move(handler)); } ///< 注册一个命令
+
+        bool remove(std::string_view name); ///< 移除一个命令词，返回该命令词是否存在
+        bool contains(std::string_view name) const; ///< 判断某个命令词是否已被注册
+        size_t size() const; ///< 获取已注册的命令词个数
+
+        /**
+         * \brief 若消息以已注册的命令词开头，则调用对应的处理函数
+         * \param ev 事件，非消息事件将被忽略
+         * \return 是否有命令被匹配
+         */
+        ex::task<bool> dispatch(const Event& ev) const;
+        ex::task<void> operator()(const Event& ev) const; ///< 同 dispatch，忽略返回值
+    };
+    MPP_RESTORE_EXPORT_WARNING
+}
@@ -1,96 +1,108 @@
 #pragma once
 
-#include <memory>
+#include <variant>
 #include <clu/type_traits.h>
 
-#include "event_base.h"
+#include "event_types.h"
 #include "../detail/json_fwd.h"
 
 namespace mpp
 {
-    MPP_SUPPRESS_EXPORT_WARNING
-    class MPP_API Event final
+    namespace detail
     {
-    private:
-        struct EventModel // NOLINT(cppcoreguidelines-special-member-functions)
+        template <typename V, size_t... Is>
+        consteval bool indices_match_event_types(std::index_sequence<Is...>)
         {
-            virtual ~EventModel() noexcept = default;
-            virtual std::unique_ptr<EventModel> clone() const = 0;
-            virtual EventType type() const noexcept = 0;
-            virtual Bot& bot() const noexcept = 0;
-            virtual EventBase& event_base() noexcept = 0; 
-        };
-
-        template <typename T>
-        class EventModelImpl final : public EventModel
-        {
-        private:
-            T data_;
-
-        public:
-            explicit EventModelImpl(const T& data): data_(data) {}
-            explicit EventModelImpl(T&& data): data_(std::move(data)) {}
-
-            T& get() { return data_; }
+            return ((std::variant_alternative_t<Is, V>::type == static_cast<EventType>(Is)) && ...);
+        }
 
-            std::unique_ptr<EventModel> clone() const override { return std::make_unique<EventModelImpl>(data_); }
-            EventType type() const noexcept override { return T::type; }
-            Bot& bot() const noexcept override { return data_.bot(); }
-            EventBase& event_base() noexcept override { return static_cast<EventBase&>(data_); }
-        };
+        template <typename F, typename Self, typename V>
+        inline constexpr bool visitable_by = false;
+        template <typename F, typename Self, typename... Ts>
+        inline constexpr bool visitable_by<F, Self, std::variant<Ts...>> =
+            (std::invocable<F, clu::copy_cvref_t<Self, Ts>> && ...);
+    }
+
+    /**
+     * \brief 将多个函数对象组合为一个重载集合，用于 Event::visit
+     * \remark \rst
+     * 例如 ``ev.visit(overloaded{ [](const GroupMessageEvent& e) { ... }, [](const auto&) { ... } })``，
+     * 其中泛型 lambda 作为默认分支处理其余所有事件类型。
+     * \endrst
+     */
+    template <typename... Fs>
+    struct overloaded : Fs... { using Fs::operator()...; };
+    template <typename... Fs> overloaded(Fs...) -> overloaded<Fs...>;
 
-        std::unique_ptr<EventModel> impl_;
+    MPP_SUPPRESS_EXPORT_WARNING
+    /**
+     * \brief Event 类存储任意一种事件类型的对象
+     * \remark 事件直接存储在对象内部，判断事件类型只需比较一个字节，不需要额外的内存分配
+     */
+    class MPP_API Event final
+    {
+    private:
+        // The alternatives are in the same order as the enumerators of EventType,
+        // so that the index of the variant is the type of the event
+        using Storage = std::variant<
+            FriendMessageEvent, GroupMessageEvent, TempMessageEvent,
+            BotOnlineEvent, BotOfflineEvent,
+            BotGroupPermissionChangeEvent, BotMutedEvent, BotUnmutedEvent, BotJoinGroupEvent, BotQuitEvent, BotKickedEvent,
+            GroupRecallEvent, FriendRecallEvent,
+            GroupNameChangeEvent, GroupEntranceAnnouncementChangeEvent, GroupConfigEvent,
+            MemberJoinEvent, MemberQuitEvent, MemberKickedEvent, MemberCardChangeEvent, MemberSpecialTitleChangeEvent,
+            MemberPermissionChangeEvent, MemberMutedEvent, MemberUnmutedEvent,
+            NewFriendRequestEvent, MemberJoinRequestEvent, BotInvitedJoinGroupRequestEvent>;
+
+        static_assert(detail::indices_match_event_types<Storage>(std::make_index_sequence<std::variant_size_v<Storage>>{}));
+
+        Storage data_;
 
         template <ConcreteEvent T, typename Self>
         static decltype(auto) get_impl(Self&& self)
         {
             if (self.type() != T::type)
                 throw std::runtime_error("事件类型不匹配");
-            T& ref = static_cast<EventModelImpl<T>&>(*self.impl_).get();
-            return static_cast<clu::copy_cvref_t<Self&&, T>>(ref);
+            return std::get<T>(std::forward<Self>(self).data_);
         }
 
-        template <ConcreteEvent T>
-        T* get_if_impl() const
+        template <typename Self, typename F>
+        static decltype(auto) visit_impl(Self&& self, F&& visitor)
         {
-            if (type() == T::type)
-                return &static_cast<EventModelImpl<T>*>(impl_.get())->get();
-            else
-                return nullptr;
+            static_assert(detail::visitable_by<F, Self&&, Storage>,
+                "访问函数必须能够处理所有的事件类型，可以添加一个泛型的默认分支");
+            return std::visit(std::forward<F>(visitor), std::forward<Self>(self).data_);
         }
 
         friend class Bot;
-        EventBase& event_base() const noexcept { return impl_->event_base(); }
+        EventBase& event_base() noexcept { return std::visit([](EventBase& base) -> EventBase& { return base; }, data_); }
 
     public:
         template <typename T> requires ConcreteEvent<std::remove_cvref_t<T>>
         explicit(false) Event(T&& ev): // NOLINT(bugprone-forwarding-reference-overload)
-            impl_(std::make_unique<EventModelImpl<std::remove_cvref_t<T>>>(std::forward<T>(ev))) {}
-
-        ~Event() noexcept = default;
-        Event(Event&&) noexcept = default;
-        Event& operator=(Event&&) noexcept = default;
-
-        Event(const Event& other): impl_(other.impl_->clone()) {}
+            data_(std::in_place_type<std::remove_cvref_t<T>>, std::forward<T>(ev)) {}
 
-        Event& operator=(const Event& other)
-        {
-            if (&other == this) return *this;
-            impl_ = other.impl_->clone();
-            return *this;
-        }
-
-        EventType type() const noexcept { return impl_->type(); }
+        EventType type() const noexcept { return static_cast<EventType>(data_.index()); }
 
         template <ConcreteEvent T> T& get() & { return get_impl<T>(*this); }
         template <ConcreteEvent T> const T& get() const & { return get_impl<T>(*this); }
         template <ConcreteEvent T> T&& get() && { return get_impl<T>(std::move(*this)); }
         template <ConcreteEvent T> const T&& get() const && { return get_impl<T>(std::move(*this)); }
 
-        template <ConcreteEvent T> T* get_if() { return get_if_impl<T>(); }
-        template <ConcreteEvent T> const T* get_if() const { return get_if_impl<T>(); }
+        template <ConcreteEvent T> T* get_if() noexcept { return std::get_if<T>(&data_); }
+        template <ConcreteEvent T> const T* get_if() const noexcept { return std::get_if<T>(&data_); }
+
+        /**
+         * \brief 以事件的具体类型调用访问函数，通过编译期生成的跳转表一次完成分派
+         * \param visitor 对所有事件类型都可调用的函数对象，各分支的返回值类型必须相同
+         * \return 访问函数的返回值
+         */
+        template <typename F> decltype(auto) visit(F&& visitor) & { return visit_impl(*this, std::forward<F>(visitor)); }
+        template <typename F> decltype(auto) visit(F&& visitor) const & { return visit_impl(*this, std::forward<F>(visitor)); }
+        template <typename F> decltype(auto) visit(F&& visitor) && { return visit_impl(std::move(*this), std::forward<F>(visitor)); }
+        template <typename F> decltype(auto) visit(F&& visitor) const && { return visit_impl(std::move(*this), std::forward<F>(visitor)); }
 
-        Bot& bot() const { return impl_->bot(); }
+        Bot& bot() const { return std::visit([](const EventBase& base) -> Bot& { return base.bot(); }, data_); }
 
         static Event from_json(detail::JsonElem json);
     };
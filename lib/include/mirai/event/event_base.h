@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <concepts>
 
@@ -20,6 +21,9 @@ namespace mpp
         new_friend_request, member_join_request, bot_invited_join_group_request
     };
 
+    /// 事件类型的个数
+    inline constexpr size_t event_type_count = static_cast<size_t>(EventType::bot_invited_join_group_request) + 1;
+
     class Bot;
 
     /// 事件基类
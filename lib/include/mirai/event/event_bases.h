@@ -3,7 +3,7 @@
 #include <unifex/task.hpp>
 #include <clu/optional_ref.h>
 
-#include "event.h"
+#include "event_base.h"
 #include "../core/info_types.h"
 #include "../message/sent_message.h"
 #include "../message/forwarded_message.h"
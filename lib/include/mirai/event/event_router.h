@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <unifex/task.hpp>
+
+#include "event.h"
+
+namespace mpp
+{
+    namespace ex = unifex;
+
+    /// 事件路由的匹配条件，未指定的条件匹配任意值
+    struct EventRoute final
+    {
+        EventType type{}; ///< 事件类型
+        std::optional<GroupId> group; ///< 事件来源的群
+        std::optional<UserId> sender; ///< 消息的发送者，或事件关联的群成员、申请人
+        std::string command; ///< 消息开头的第一个词，为空时不限制，仅对消息事件有效
+    };
+
+    MPP_SUPPRESS_EXPORT_WARNING
+    /**
+     * \brief 按事件类型、群号、发送者和命令词建立索引的事件路由
+     * \remark \rst
+     * 每个事件只会在与其类型对应的索引中查找处理函数，因此分发的开销不随注册的处理函数个数线性增长。
+     * 路由对象可以直接作为 ``monitor_events_async`` 的回调函数使用。注册与分发可以在不同线程上同时进行。
+     * \endrst
+     */
+    class MPP_API EventRouter final
+    {
+    public:
+        using Handler = std::function<ex::task<void>(const Event&)>; ///< 事件处理函数
+        using HandlerId = size_t; ///< 注册处理函数时得到的 id，用于移除处理函数
+
+    private:
+        struct Entry
+        {
+            EventRoute route;
+            std::shared_ptr<const Handler> handler;
+        };
+
+        struct StringHash
+        {
+            using is_transparent = void;
+            size_t operator()(std::string_view str) const noexcept { return std::hash<std::string_view>{}(str); }
+        };
+
+        // Every route is indexed by its most selective key, the other keys are checked on matching
+        struct Bucket
+        {
+            std::vector<HandlerId> any;
+            std::unordered_map<int64_t, std::vector<HandlerId>> by_group;
+            std::unordered_map<int64_t, std::vector<HandlerId>> by_sender;
+            std::unordered_map<std::string, std::vector<HandlerId>, StringHash, std::equal_to<>> by_command;
+        };
+
+        mutable std::shared_mutex mutex_;
+        std::vector<std::optional<Entry>> entries_;
+        std::array<Bucket, event_type_count> buckets_;
+        size_t size_ = 0;
+
+        std::vector<HandlerId>& index_of(const EventRoute& route);
+
+    public:
+        /**
+         * \brief 注册一个处理函数
+         * \param route 匹配条件
+         * \param handler 处理函数
+         * \return 处理函数的 id
+         */
+        HandlerId add(EventRoute route, Handler handler);
+
+        /**
+         * \brief 注册一个处理某种具体事件类型的处理函数
+         * \tparam E 事件类型
+         * \param handler 以 const E& 为参数的处理函数
+         * \param route 其余的匹配条件，其中的事件类型会被忽略
+         * \return 处理函数的 id
+         */
+        template <ConcreteEvent E, std::invocable<const E&> F>
+        HandlerId on(F handler, EventRoute route = {})
+        {
+            route.type = E::type;
+            return add(std::move(route),
+                [handler = std::move(handler)](const Event& ev) -> ex::task<void> { return handler(ev.get<E>()); });
+        }
+
+        /**
+         * \brief 注册一个处理以某个命令词开头的消息的处理函数
+         * \tparam E 消息事件类型
+         * \param command 命令词，即消息开头的第一个词
+         * \param handler 以 const E& 为参数的处理函数
+         * \return 处理函数的 id
+         */
+        template <ConcreteEvent E, std::invocable<const E&> F> requires std::derived_from<E, MessageEventBase>
+        HandlerId on_command(std::string command, F handler)
+        {
+            return on<E>(std::move(handler), { .command = std::move(command) });
+        }
+
+        bool remove(HandlerId id); ///< 移除一个处理函数，返回是否找到了该处理函数
+        size_t size() const; ///< 获取已注册的处理函数个数
+
+        /**
+         * \brief 查找与事件匹配的所有处理函数
+         * \param ev 事件
+         * \return 按注册顺序排列的处理函数
+         */
+        std::vector<std::shared_ptr<const Handler>> match(const Event& ev) const;
+
+        /**
+         * \brief 按注册顺序依次调用与事件匹配的所有处理函数
+         * \param ev 事件
+         */
+        ex::task<void> dispatch(const Event& ev) const;
+        ex::task<void> operator()(const Event& ev) const { return dispatch(ev); } ///< 同 dispatch
+    };
+    MPP_RESTORE_EXPORT_WARNING
+}
@@ -1,6 +1,5 @@
 #pragma once
 
-#include "event.h"
 #include "event_bases.h"
 
 namespace mpp
@@ -400,3 +399,5 @@ namespace mpp
 
     MPP_RESTORE_EXPORT_WARNING
 }
+
+#include "event.h" // Event stores the types above inline, so it can only be defined after them
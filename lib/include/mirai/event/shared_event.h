@@ -0,0 +1,40 @@
+#pragma once
+
+#include "event.h"
+
+namespace mpp
+{
+    /**
+     * \brief 共享所有权的不可变事件
+     * \remark \rst
+     * 复制 ``SharedEvent`` 只会增加引用计数而不会复制事件内容，引用计数是线程安全的，
+     * 因此同一个事件可以分发给任意多个处理函数。需要修改事件时，可以通过 ``clone`` 得到一份独立的副本。
+     * \endrst
+     */
+    class SharedEvent final
+    {
+    private:
+        std::shared_ptr<const Event> ptr_;
+
+    public:
+        explicit(false) SharedEvent(Event&& ev): ptr_(std::make_shared<const Event>(std::move(ev))) {}
+        explicit SharedEvent(const Event& ev): ptr_(std::make_shared<const Event>(ev)) {}
+
+        template <typename T> requires ConcreteEvent<std::remove_cvref_t<T>>
+        explicit(false) SharedEvent(T&& ev): // NOLINT(bugprone-forwarding-reference-overload)
+            ptr_(std::make_shared<const Event>(std::forward<T>(ev))) {}
+
+        EventType type() const noexcept { return ptr_->type(); }
+        template <ConcreteEvent T> const T& get() const { return ptr_->get<T>(); }
+        template <ConcreteEvent T> const T* get_if() const { return ptr_->get_if<T>(); }
+        template <typename F> decltype(auto) visit(F&& visitor) const { return ptr_->visit(std::forward<F>(visitor)); }
+        Bot& bot() const { return ptr_->bot(); }
+
+        const Event& event() const noexcept { return *ptr_; } ///< 获取共享的事件
+        const Event& operator*() const noexcept { return *ptr_; }
+        const Event* operator->() const noexcept { return ptr_.get(); }
+        Event clone() const { return *ptr_; } ///< 复制得到一个可修改的事件
+
+        long use_count() const noexcept { return ptr_.use_count(); } ///< 获取共享该事件的对象个数
+    };
+}
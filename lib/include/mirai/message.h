@@ -1,4 +1,7 @@
 #pragma once
 
+#include "message/command_trie.h"
 #include "message/forwarded_message.h"
+#include "message/keyword_matcher.h"
+#include "message/message_tokenizer.h"
 #include "message/sent_message.h"
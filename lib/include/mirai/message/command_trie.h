@@ -0,0 +1,68 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "../core/export.h"
+
+namespace mpp
+{
+    MPP_SUPPRESS_EXPORT_WARNING
+    /**
+     * \brief 以命令词为键的基数树（压缩前缀树）
+     * \remark \rst
+     * 查找消息开头的命令词时只需按字符沿树向下走一次，耗时与命令词的长度成正比，而与命令的个数无关。
+     * 命令词只在词边界处匹配，即命令词之后必须是文本的结尾或空白字符。
+     * \endrst
+     */
+    class MPP_API CommandTrie final
+    {
+    public:
+        /// 一次匹配的结果
+        struct Match
+        {
+            size_t value = 0; ///< 命令词对应的值
+            size_t length = 0; ///< 命令词的长度
+        };
+
+    private:
+        struct Node
+        {
+            std::string label; // The edge from the parent to this node
+            std::optional<size_t> value;
+            std::vector<Node> children; // Sorted by the first character of the labels
+        };
+
+        Node root_;
+        size_t size_ = 0;
+
+        static std::vector<Node>::iterator find_child(Node& node, char first) noexcept;
+        static const Node* find_child(const Node& node, char first) noexcept;
+        Node* find_node(std::string_view key) noexcept;
+
+    public:
+        static bool is_valid_key(std::string_view key) noexcept; ///< 判断一个字符串能否作为命令词，即非空且不含空白字符
+
+        /**
+         * \brief 插入一个命令词，若已存在则替换其对应的值
+         * \param key 命令词，不能为空，也不能包含空白字符
+         * \param value 命令词对应的值
+         */
+        void insert(std::string_view key, size_t value);
+        bool erase(std::string_view key); ///< 移除一个命令词，返回该命令词是否存在
+        std::optional<size_t> find(std::string_view key) const; ///< 查找与键完全相同的命令词对应的值
+
+        /**
+         * \brief 查找文本开头最长的命令词
+         * \param text 要匹配的文本
+         * \return 匹配的结果，没有任何命令词匹配时返回空
+         */
+        std::optional<Match> match(std::string_view text) const;
+
+        size_t size() const noexcept { return size_; } ///< 获取命令词的个数
+        bool empty() const noexcept { return size_ == 0; } ///< 判断是否没有任何命令词
+        void clear() noexcept; ///< 清空所有命令词
+    };
+    MPP_RESTORE_EXPORT_WARNING
+}
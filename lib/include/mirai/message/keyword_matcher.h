@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "message.h"
+
+namespace mpp
+{
+    MPP_SUPPRESS_EXPORT_WARNING
+    /**
+     * \brief 编译后的关键词集合，使用 Aho-Corasick 自动机一次扫描即可找出文本中出现的所有关键词
+     * \remark \rst
+     * 扫描的耗时与文本长度和匹配次数成正比，而与关键词的个数无关。关键词按字节匹配，区分大小写。
+     * 关键词的 id 即其在构造时传入的序列中的下标。集合在构造后不可修改，可以在多个线程上同时使用。
+     * \endrst
+     */
+    class MPP_API KeywordSet final
+    {
+    private:
+        struct State
+        {
+            uint32_t edges_begin = 0, edges_end = 0; // Outgoing edges in edges_, sorted by byte
+            uint32_t outputs_begin = 0, outputs_end = 0; // Patterns ending here in outputs_, including suffixes
+            uint32_t fail = 0;
+        };
+
+        struct Edge
+        {
+            uint8_t byte = 0;
+            uint32_t target = 0;
+        };
+
+        std::vector<std::string> patterns_;
+        std::vector<State> states_;
+        std::vector<Edge> edges_;
+        std::vector<uint32_t> outputs_;
+        std::array<uint32_t, 256> root_next_{}; // The root takes most transitions, so its table is dense
+
+        uint32_t next_state(uint32_t state, uint8_t byte) const noexcept;
+        template <typename F> uint32_t scan(uint32_t state, std::string_view text, F&& on_match) const;
+        template <typename F> void scan(const Message& msg, F&& on_match) const;
+        bool contains_any_sv(std::string_view text) const;
+        std::vector<size_t> match_sv(std::string_view text) const;
+
+    public:
+        KeywordSet() = default; ///< 创建一个空的关键词集合
+        explicit KeywordSet(std::vector<std::string> patterns); ///< 编译一个关键词集合，空的关键词将被忽略
+
+        size_t size() const noexcept { return patterns_.size(); } ///< 获取关键词的个数
+        std::string_view pattern(const size_t id) const { return patterns_.at(id); } ///< 获取某个 id 对应的关键词
+
+        template <std::convertible_to<std::string_view> T>
+        bool contains_any(const T& text) const { return contains_any_sv(text); } ///< 判断文本中是否出现了任何关键词
+        template <std::convertible_to<std::string_view> T>
+        std::vector<size_t> match(const T& text) const { return match_sv(text); } ///< 获取文本中出现的所有关键词 id，按升序排列且不重复
+
+        /**
+         * \brief 判断消息的文本中是否出现了任何关键词
+         * \remark 相邻的纯文本消息段视为连续的文本，关键词可以跨越这些消息段
+         */
+        bool contains_any(const Message& msg) const;
+
+        /**
+         * \brief 获取消息的文本中出现的所有关键词 id，按升序排列且不重复
+         * \remark 相邻的纯文本消息段视为连续的文本，关键词可以跨越这些消息段
+         */
+        std::vector<size_t> match(const Message& msg) const;
+    };
+
+    /**
+     * \brief 可在运行时整体替换关键词集合的关键词匹配器
+     * \remark \rst
+     * 替换关键词集合时，正在进行的匹配会继续使用原有的集合完成，新的匹配使用新的集合。
+     * 编译新的集合在调用 ``reset`` 的线程上完成，不会阻塞匹配。
+     * \endrst
+     */
+    class MPP_API KeywordMatcher final
+    {
+    private:
+        mutable std::mutex mutex_;
+        std::shared_ptr<const KeywordSet> set_ = std::make_shared<const KeywordSet>();
+
+    public:
+        KeywordMatcher() = default; ///< 创建一个没有关键词的匹配器
+        explicit KeywordMatcher(std::vector<std::string> patterns) { reset(std::move(patterns)); } ///< 以一组关键词创建匹配器
+
+        void reset(std::vector<std::string> patterns); ///< 编译一组新的关键词并替换当前的关键词集合
+        void reset(std::shared_ptr<const KeywordSet> set); ///< 替换当前的关键词集合
+        std::shared_ptr<const KeywordSet> snapshot() const; ///< 获取当前的关键词集合
+
+        template <typename T>
+        bool contains_any(const T& text_or_msg) const { return snapshot()->contains_any(text_or_msg); } ///< 同 KeywordSet::contains_any
+        template <typename T>
+        std::vector<size_t> match(const T& text_or_msg) const { return snapshot()->match(text_or_msg); } ///< 同 KeywordSet::match
+    };
+    MPP_RESTORE_EXPORT_WARNING
+}
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <ranges>
 #include <clu/concepts.h>
@@ -9,6 +13,17 @@
 namespace mpp
 {
     MPP_SUPPRESS_EXPORT_WARNING
+    /// 由消息内容计算得到的数据，在第一次使用时计算，并由该消息的所有使用者共享
+    struct MPP_API MessageDerivedData final
+    {
+        std::string text; ///< 所有纯文本消息段连接而成的字符串
+        std::string normalized_text; ///< 将全角字符转换为半角、ASCII 字母转换为小写后的 text
+        std::array<size_t, segment_type_count> segment_counts{}; ///< 各类型消息段的个数，以 SegmentType 为下标
+        uint64_t content_hash = 0; ///< 消息内容的哈希值，见 Message::content_hash
+
+        static MessageDerivedData compute(const std::vector<Segment>& segments);
+    };
+
     /// 表示一条可能由多个消息段 \c Segment 组成的完整消息
     class MPP_API Message final
     {
@@ -20,6 +35,19 @@ namespace mpp
 
     private:
         std::vector<Segment> vec_;
+        // Computed lazily by const members and dropped by the mutators. Guarded by a spin lock
+        // instead of being an std::atomic<std::shared_ptr>, which not every standard library provides
+        mutable std::shared_ptr<const MessageDerivedData> derived_;
+        mutable std::atomic_flag derived_lock_;
+
+        std::shared_ptr<const MessageDerivedData> load_derived() const noexcept;
+        std::shared_ptr<const MessageDerivedData> exchange_derived(std::shared_ptr<const MessageDerivedData> ptr) noexcept;
+
+        std::vector<Segment>& mutable_vec() noexcept
+        {
+            invalidate_derived();
+            return vec_;
+        }
 
         bool starts_with_sv(std::string_view sv) const;
         bool ends_with_sv(std::string_view sv) const;
@@ -33,6 +61,25 @@ namespace mpp
             (vec_.emplace_back(std::forward<Ts>(segments)), ...);
         }
 
+        ~Message() noexcept = default;
+        Message(const Message& other): vec_(other.vec_), derived_(other.load_derived()) {}
+        Message(Message&& other) noexcept: vec_(std::move(other.vec_)), derived_(other.exchange_derived(nullptr)) {}
+
+        Message& operator=(const Message& other)
+        {
+            if (&other == this) return *this;
+            vec_ = other.vec_;
+            exchange_derived(other.load_derived());
+            return *this;
+        }
+
+        Message& operator=(Message&& other) noexcept
+        {
+            vec_ = std::move(other.vec_);
+            exchange_derived(other.exchange_derived(nullptr));
+            return *this;
+        }
+
         /// \defgroup MsgIdx
         /// \{
         Segment& at(const size_t index) { return vec_.at(index); }
@@ -49,7 +96,7 @@ namespace mpp
 
         std::vector<Segment>& get_vector() & { return vec_; }
         const std::vector<Segment>& get_vector() const & { return vec_; }
-        std::vector<Segment>&& get_vector() && { return std::move(vec_); }
+        std::vector<Segment>&& get_vector() && { return std::move(mutable_vec()); }
         const std::vector<Segment>&& get_vector() const && { return std::move(vec_); } // NOLINT(performance-move-const-arg)
 
         auto begin() { return vec_.begin(); }
@@ -74,7 +121,7 @@ namespace mpp
         template <typename T> requires std::convertible_to<T&&, Segment>
         Message& operator+=(T&& segment)
         {
-            vec_.emplace_back(std::forward<T>(segment));
+            mutable_vec().emplace_back(std::forward<T>(segment));
             return *this;
         }
 
@@ -84,15 +131,16 @@ namespace mpp
         /// 在本消息末尾连接另一条消息
         Message& operator+=(const Message& other)
         {
-            vec_.insert(vec_.end(), other.begin(), other.end());
+            mutable_vec().insert(vec_.end(), other.begin(), other.end());
             return *this;
         }
 
         /// 在本消息末尾连接另一条消息
         Message& operator+=(Message&& other)
         {
-            vec_.insert(vec_.end(),
+            mutable_vec().insert(vec_.end(),
                 std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+            other.invalidate_derived(); // The segments of the other message have been moved from
             return *this;
         }
 
@@ -107,7 +155,7 @@ namespace mpp
 
         /// \defgroup MsgCmp
         /// \{
-        bool operator==(const Message& other) const noexcept = default;
+        bool operator==(const Message& other) const noexcept { return vec_ == other.vec_; }
         bool operator==(const Segment& other) const noexcept { return size() == 1 && front() == other; }
 
         template <std::convertible_to<std::string_view> T>
@@ -129,8 +177,12 @@ namespace mpp
         }
         /// \}
 
-        void clear() { vec_.clear(); } ///< 清空当前消息
-        void swap(Message& other) noexcept { vec_.swap(other.vec_); } ///< 将当前消息与另一个消息互换
+        void clear() { mutable_vec().clear(); } ///< 清空当前消息
+        void swap(Message& other) noexcept ///< 将当前消息与另一个消息互换
+        {
+            vec_.swap(other.vec_);
+            exchange_derived(other.exchange_derived(exchange_derived(nullptr)));
+        }
         friend void swap(Message& lhs, Message& rhs) noexcept { lhs.swap(rhs); } ///< 将两条消息互换
 
         void collapse_adjacent_text(); ///< 将相邻的纯文本消息段合并成一个消息段
@@ -150,6 +202,13 @@ namespace mpp
         bool starts_with(const Segment& prefix) const;
         bool starts_with(const Message& prefix) const;
 
+        /// 判断两条消息的各消息段是否依次满足 Segment::same_content
+        bool same_content(const Message& other) const
+        {
+            return std::ranges::equal(vec_, other.vec_,
+                [](const Segment& lhs, const Segment& rhs) { return lhs.same_content(rhs); });
+        }
+
         /// 获取遍历该消息中所有特定类型消息段的范围
         template <ConcreteSegment T>
         auto collect() const
@@ -161,9 +220,49 @@ namespace mpp
 
         std::string collect_text() const; ///< 获取消息中所有纯文本消息段连接而成的字符串
 
+        /// \defgroup MsgDerived
+        /// \{
+
+        /**
+         * \brief 获取由消息内容计算得到的数据，第一次调用时计算并缓存
+         * \remark \rst
+         * 缓存在消息被复制时一并共享，并在 ``operator+=``、``clear`` 等修改消息的成员函数调用后失效。
+         * ``begin``、``operator[]``、``get_vector`` 等非 const 访问函数不会使缓存失效，
+         * 通过它们得到的引用修改消息段之后，需要手动调用 ``invalidate_derived``。
+         * 可以在多个线程上同时对同一条消息调用，返回的指针在消息被修改后仍然有效。
+         * \endrst
+         */
+        std::shared_ptr<const MessageDerivedData> derived() const;
+        std::string text() const { return derived()->text; } ///< 获取缓存的 collect_text 结果，需要避免复制时可以持有 derived 的结果
+        std::string normalized_text() const { return derived()->normalized_text; } ///< 获取缓存的规范化文本，需要避免复制时可以持有 derived 的结果
+        size_t count(const SegmentType type) const { return derived()->segment_counts[static_cast<size_t>(type)]; } ///< 获取某种类型消息段的个数
+        uint64_t content_hash() const { return derived()->content_hash; } ///< 获取由各消息段的 Segment::content_hash 组合而成的哈希值，与 same_content 一致
+        void invalidate_derived() noexcept { exchange_derived(nullptr); } ///< 丢弃缓存的数据
+        /// \}
+
         void format_to(fmt::format_context& ctx) const;
         void format_as_json(fmt::format_context& ctx) const;
         static Message from_json(detail::JsonElem json);
     };
     MPP_RESTORE_EXPORT_WARNING
 }
+
+namespace mpp
+{
+    /**
+     * \brief 按 Message::content_hash 计算哈希值，与 MessageContentEqual 一同用于按内容查重的哈希容器
+     * \remark \rst
+     * 如 ``std::unordered_set<Message, MessageContentHash, MessageContentEqual>``，哈希值缓存在消息内部，重复查找的开销很小。
+     * \endrst
+     */
+    struct MessageContentHash final
+    {
+        size_t operator()(const Message& msg) const { return static_cast<size_t>(msg.content_hash()); }
+    };
+
+    /// 按 Message::same_content 比较两条消息
+    struct MessageContentEqual final
+    {
+        bool operator()(const Message& lhs, const Message& rhs) const { return lhs.same_content(rhs); }
+    };
+}
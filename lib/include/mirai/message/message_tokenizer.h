@@ -0,0 +1,92 @@
+#pragma once
+
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string_view>
+
+#include "message.h"
+
+namespace mpp
+{
+    /// 消息分词的选项
+    struct TokenizerOptions final
+    {
+        bool quotes = true; ///< 是否将一对双引号或单引号括起的文本视为一个词，引号内不支持转义
+    };
+
+    /// 消息分词得到的一个词，为一段文本或一个非纯文本的消息段
+    struct MessageToken final
+    {
+        std::string_view text; ///< 文本，指向原消息段中的字符串
+        const Segment* segment = nullptr; ///< 非纯文本的消息段，为文本时为空
+        bool quoted = false; ///< 文本是否被引号括起
+
+        bool is_text() const noexcept { return segment == nullptr; } ///< 判断当前词是否为文本
+
+        /// 获取指定类型的消息段，类型不符或当前词为文本时返回空
+        template <ConcreteSegment T>
+        const T* get_if() const noexcept { return segment ? segment->get_if<T>() : nullptr; }
+    };
+
+    MPP_SUPPRESS_EXPORT_WARNING
+    /**
+     * \brief 将消息按空白字符切分为词，不进行任何内存分配
+     * \remark \rst
+     * 文本词以 ``std::string_view`` 的形式直接指向消息中 ``Plain`` 消息段的字符串，因此在使用分词结果时原消息必须保持有效。
+     * ``At``、``Image``、``Face`` 等非纯文本的消息段按原顺序作为单独的词给出。
+     * 词不会跨越消息段，即被拆成两个相邻纯文本消息段的词会被视为两个词。
+     * \endrst
+     */
+    class MPP_API MessageTokenizer final
+    {
+    public:
+        class iterator
+        {
+        private:
+            MessageTokenizer* tokenizer_ = nullptr;
+            std::optional<MessageToken> token_;
+
+        public:
+            using value_type = MessageToken;
+            using difference_type = std::ptrdiff_t;
+
+            iterator() = default;
+            explicit iterator(MessageTokenizer& tokenizer): tokenizer_(&tokenizer), token_(tokenizer.next()) {}
+
+            const MessageToken& operator*() const noexcept { return *token_; }
+            const MessageToken* operator->() const noexcept { return &*token_; }
+            iterator& operator++() { token_ = tokenizer_->next(); return *this; }
+            void operator++(int) { ++*this; }
+            friend bool operator==(const iterator& it, std::default_sentinel_t) noexcept { return !it.token_; }
+        };
+
+    private:
+        std::string_view text_;
+        const Segment* seg_ = nullptr;
+        const Segment* end_ = nullptr;
+        TokenizerOptions options_;
+
+    public:
+        /// 对一条消息分词，不接受可以隐式转换为消息的其他类型，以免分词结果指向临时对象
+        template <std::same_as<Message> M>
+        explicit MessageTokenizer(const M& msg, const TokenizerOptions options = {}):
+            MessageTokenizer({}, std::span(msg.data(), msg.size()), options) {}
+
+        /**
+         * \brief 对一段开头的文本及其后的消息段分词，如命令的参数
+         * \param text 开头的文本
+         * \param segments 其后的消息段
+         * \param options 分词选项
+         */
+        MessageTokenizer(const std::string_view text, const std::span<const Segment> segments,
+            const TokenizerOptions options = {}) noexcept:
+            text_(text), seg_(segments.data()), end_(segments.data() + segments.size()), options_(options) {}
+
+        std::optional<MessageToken> next() noexcept; ///< 获取下一个词，没有更多的词时返回空
+
+        iterator begin() { return iterator(*this); } ///< 开始迭代剩余的词
+        std::default_sentinel_t end() const noexcept { return {}; }
+    };
+    MPP_RESTORE_EXPORT_WARNING
+}
@@ -128,9 +128,38 @@ namespace mpp
         template <ConcreteSegment T> T* get_if() noexcept { return get_if_impl<T>(); }
         template <ConcreteSegment T> const T* get_if() const noexcept { return get_if_impl<T>(); }
 
+        /**
+         * \brief 计算消息段内容的 64 位哈希值，结果在不同平台和不同次运行之间保持一致
+         * \remark \rst
+         * 与 ``same_content`` 使用相同的字段，二者一同用于按内容查重的哈希容器，见 ``SegmentContentHash``。
+         * 图片、语音和表情按其标识计算，即依次取 id、链接和路径中第一个存在的值。
+         * 由于 ``operator==`` 在任意一项标识相同时即认为相等，该哈希值与 ``operator==`` 并不一致，
+         * 因此 ``Segment`` 没有特化 ``std::hash``。
+         * \endrst
+         */
+        uint64_t content_hash() const;
+
+        /// 判断两个消息段的内容是否相同，图片、语音和表情只比较 content_hash 所用的标识
+        bool same_content(const Segment& other) const;
+
         void format_to(fmt::format_context& ctx) const { impl_->format_to(ctx); }
         void format_as_json(fmt::format_context& ctx) const { impl_->format_as_json(ctx); }
         static Segment from_json(detail::JsonElem json);
     };
     MPP_RESTORE_EXPORT_WARNING
 }
+
+namespace mpp
+{
+    /// 按 Segment::content_hash 计算哈希值，与 SegmentContentEqual 一同用于按内容查重的哈希容器
+    struct SegmentContentHash final
+    {
+        size_t operator()(const Segment& segment) const { return static_cast<size_t>(segment.content_hash()); }
+    };
+
+    /// 按 Segment::same_content 比较两个消息段
+    struct SegmentContentEqual final
+    {
+        bool operator()(const Segment& lhs, const Segment& rhs) const { return lhs.same_content(rhs); }
+    };
+}
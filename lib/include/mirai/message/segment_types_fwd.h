@@ -24,6 +24,9 @@ namespace mpp
         poke, forward, file
     };
 
+    /// 消息段类型的个数
+    inline constexpr size_t segment_type_count = static_cast<size_t>(SegmentType::file) + 1;
+
     /// 消息段组成类型概念
     template <typename T> concept ConcreteSegment = requires { { T::type } -> std::convertible_to<SegmentType>; };
 }
@@ -0,0 +1,476 @@
+#include "mirai/core/binary_codec.h"
+
+#include <chrono>
+#include <stdexcept>
+
+#include "mirai/message/forwarded_message.h"
+#include "mirai/message/segment_types.h"
+
+namespace mpp
+{
+    namespace
+    {
+        // Kind of the encoded content, stored right after the version byte
+        enum class Kind : uint8_t { message, sent_message, event };
+
+        template <typename T> inline constexpr bool is_optional = false;
+        template <typename T> inline constexpr bool is_optional<std::optional<T>> = true;
+        template <typename T> inline constexpr bool is_vector = false;
+        template <typename T> inline constexpr bool is_vector<std::vector<T>> = true;
+
+        template <typename T>
+        concept IdType = std::same_as<T, UserId> || std::same_as<T, GroupId> || std::same_as<T, MessageId>;
+
+        // Matches both T and const T, so that a single transfer function describes
+        // the layout of a type for both the writer and the reader
+        template <typename T, typename U>
+        concept MaybeConst = std::same_as<std::remove_const_t<T>, U>;
+
+        template <typename B, typename T>
+        auto& as_base(T& value)
+        {
+            if constexpr (std::is_const_v<T>) return static_cast<const B&>(value);
+            else return static_cast<B&>(value);
+        }
+
+        class Writer
+        {
+        private:
+            std::string& out_;
+
+        public:
+            explicit Writer(std::string& out): out_(out) {}
+
+            void byte(const uint8_t value) { out_ += static_cast<char>(value); }
+
+            void varint(uint64_t value)
+            {
+                while (value >= 0x80)
+                {
+                    byte(static_cast<uint8_t>(value | 0x80));
+                    value >>= 7;
+                }
+                byte(static_cast<uint8_t>(value));
+            }
+
+            template <typename T>
+            void operator()(const T& value)
+            {
+                if constexpr (std::same_as<T, bool>)
+                    byte(value ? 1 : 0);
+                else if constexpr (std::is_enum_v<T>)
+                    varint(static_cast<uint64_t>(value));
+                else if constexpr (std::signed_integral<T>)
+                {
+                    const auto v = static_cast<int64_t>(value);
+                    varint((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63)); // zigzag
+                }
+                else if constexpr (std::unsigned_integral<T>)
+                    varint(value);
+                else if constexpr (IdType<T>)
+                    (*this)(value.id);
+                else if constexpr (std::same_as<T, std::chrono::seconds>)
+                    (*this)(static_cast<int64_t>(value.count()));
+                else if constexpr (std::same_as<T, std::string>)
+                {
+                    varint(value.size());
+                    out_ += value;
+                }
+                else if constexpr (is_optional<T>)
+                {
+                    (*this)(value.has_value());
+                    if (value) (*this)(*value);
+                }
+                else if constexpr (is_vector<T>)
+                {
+                    varint(value.size());
+                    for (const auto& elem : value) (*this)(elem);
+                }
+                else
+                    transfer(*this, value);
+            }
+        };
+
+        class Reader
+        {
+        private:
+            std::string_view in_;
+
+        public:
+            explicit Reader(const std::string_view in): in_(in) {}
+
+            bool done() const noexcept { return in_.empty(); }
+
+            uint8_t byte()
+            {
+                if (in_.empty()) throw std::runtime_error("二进制数据不完整");
+                const auto value = static_cast<uint8_t>(in_.front());
+                in_.remove_prefix(1);
+                return value;
+            }
+
+            uint64_t varint()
+            {
+                uint64_t value = 0;
+                for (int shift = 0; shift < 64; shift += 7)
+                {
+                    const uint8_t b = byte();
+                    value |= static_cast<uint64_t>(b & 0x7f) << shift;
+                    if (!(b & 0x80)) return value;
+                }
+                throw std::runtime_error("二进制数据中的整数过长");
+            }
+
+            // Every element takes at least one byte, so a count larger than the
+            // remaining input must come from corrupted data
+            size_t count()
+            {
+                const uint64_t n = varint();
+                if (n > in_.size()) throw std::runtime_error("二进制数据不完整");
+                return static_cast<size_t>(n);
+            }
+
+            template <typename T>
+            void operator()(T& value)
+            {
+                if constexpr (std::same_as<T, bool>)
+                    value = byte() != 0;
+                else if constexpr (std::is_enum_v<T>)
+                    value = static_cast<T>(varint());
+                else if constexpr (std::signed_integral<T>)
+                {
+                    const uint64_t u = varint();
+                    value = static_cast<T>(static_cast<int64_t>(u >> 1) ^ -static_cast<int64_t>(u & 1));
+                }
+                else if constexpr (std::unsigned_integral<T>)
+                    value = static_cast<T>(varint());
+                else if constexpr (IdType<T>)
+                    (*this)(value.id);
+                else if constexpr (std::same_as<T, std::chrono::seconds>)
+                {
+                    int64_t count = 0;
+                    (*this)(count);
+                    value = std::chrono::seconds(count);
+                }
+                else if constexpr (std::same_as<T, std::string>)
+                {
+                    const size_t size = count();
+                    value.assign(in_.substr(0, size));
+                    in_.remove_prefix(size);
+                }
+                else if constexpr (is_optional<T>)
+                {
+                    bool has_value = false;
+                    (*this)(has_value);
+                    if (has_value) (*this)(value.emplace());
+                    else value.reset();
+                }
+                else if constexpr (is_vector<T>)
+                {
+                    const size_t size = count();
+                    value.clear();
+                    value.reserve(size);
+                    for (size_t i = 0; i < size; i++) (*this)(value.emplace_back());
+                }
+                else
+                    transfer(*this, value);
+            }
+        };
+
+        // Segments
+
+        template <typename Io, MaybeConst<At> T> void transfer(Io& io, T& v) { io(v.target); io(v.display); }
+        template <typename Io, MaybeConst<AtAll> T> void transfer(Io&, T&) {}
+        template <typename Io, MaybeConst<Face> T> void transfer(Io& io, T& v) { io(v.face_id); io(v.name); }
+        template <typename Io, MaybeConst<Plain> T> void transfer(Io& io, T& v) { io(v.text); }
+        template <typename Io, MaybeConst<Image> T> void transfer(Io& io, T& v) { io(v.image_id); io(v.url); io(v.path); }
+        template <typename Io, MaybeConst<FlashImage> T> void transfer(Io& io, T& v) { io(v.image_id); io(v.url); io(v.path); }
+        template <typename Io, MaybeConst<Voice> T> void transfer(Io& io, T& v) { io(v.voice_id); io(v.url); io(v.path); }
+        template <typename Io, MaybeConst<Xml> T> void transfer(Io& io, T& v) { io(v.xml); }
+        template <typename Io, MaybeConst<Json> T> void transfer(Io& io, T& v) { io(v.json); }
+        template <typename Io, MaybeConst<App> T> void transfer(Io& io, T& v) { io(v.content); }
+        template <typename Io, MaybeConst<Poke> T> void transfer(Io& io, T& v) { io(v.name); }
+
+        template <typename Io, MaybeConst<Forward> T>
+        void transfer(Io& io, T& v)
+        {
+            io(v.title);
+            io(v.brief);
+            io(v.source);
+            io(v.summary);
+            io(v.messages);
+        }
+
+        template <typename Io, MaybeConst<ForwardedMessage> T>
+        void transfer(Io& io, T& v)
+        {
+            io(v.sender);
+            io(v.time);
+            io(v.sender_name);
+            io(v.content);
+        }
+
+        void transfer(Writer& w, const Segment& seg)
+        {
+            w(seg.type());
+            // @formatter:off
+            switch (seg.type())
+            {
+                case SegmentType::at:          w(seg.get<At>()); return;
+                case SegmentType::at_all:      w(seg.get<AtAll>()); return;
+                case SegmentType::face:        w(seg.get<Face>()); return;
+                case SegmentType::plain:       w(seg.get<Plain>()); return;
+                case SegmentType::image:       w(seg.get<Image>()); return;
+                case SegmentType::flash_image: w(seg.get<FlashImage>()); return;
+                case SegmentType::voice:       w(seg.get<Voice>()); return;
+                case SegmentType::xml:         w(seg.get<Xml>()); return;
+                case SegmentType::json:        w(seg.get<Json>()); return;
+                case SegmentType::app:         w(seg.get<App>()); return;
+                case SegmentType::poke:        w(seg.get<Poke>()); return;
+                case SegmentType::forward:     w(seg.get<Forward>()); return;
+                default: break;
+            }
+            // @formatter:on
+            throw std::runtime_error("该消息段类型不支持二进制编码");
+        }
+
+        template <typename T>
+        Segment read_segment(Reader& r)
+        {
+            T seg;
+            r(seg);
+            return Segment(std::move(seg));
+        }
+
+        Segment read_segment(Reader& r)
+        {
+            SegmentType type{};
+            r(type);
+            // @formatter:off
+            switch (type)
+            {
+                case SegmentType::at:          return read_segment<At>(r);
+                case SegmentType::at_all:      return read_segment<AtAll>(r);
+                case SegmentType::face:        return read_segment<Face>(r);
+                case SegmentType::plain:       return read_segment<Plain>(r);
+                case SegmentType::image:       return read_segment<Image>(r);
+                case SegmentType::flash_image: return read_segment<FlashImage>(r);
+                case SegmentType::voice:       return read_segment<Voice>(r);
+                case SegmentType::xml:         return read_segment<Xml>(r);
+                case SegmentType::json:        return read_segment<Json>(r);
+                case SegmentType::app:         return read_segment<App>(r);
+                case SegmentType::poke:        return read_segment<Poke>(r);
+                case SegmentType::forward:     return read_segment<Forward>(r);
+                default: break;
+            }
+            // @formatter:on
+            throw std::runtime_error("二进制数据中的消息段类型无效");
+        }
+
+        void transfer(Writer& w, const Message& msg)
+        {
+            w.varint(msg.size());
+            for (const Segment& seg : msg) transfer(w, seg);
+        }
+
+        void transfer(Reader& r, Message& msg)
+        {
+            const size_t size = r.count();
+            msg.clear();
+            msg.reserve(size);
+            for (size_t i = 0; i < size; i++) msg += read_segment(r);
+        }
+
+        // Messages and info types
+
+        template <typename Io, MaybeConst<Source> T> void transfer(Io& io, T& v) { io(v.id); io(v.time); }
+        template <typename Io, MaybeConst<Quote> T> void transfer(Io& io, T& v) { io(v.id); io(v.sender); io(v.time); io(v.msg); }
+        template <typename Io, MaybeConst<SentMessage> T> void transfer(Io& io, T& v) { io(v.source); io(v.quote); io(v.content); }
+        template <typename Io, MaybeConst<Friend> T> void transfer(Io& io, T& v) { io(v.id); io(v.name); io(v.remark); }
+        template <typename Io, MaybeConst<Group> T> void transfer(Io& io, T& v) { io(v.id); io(v.name); io(v.permission); }
+        template <typename Io, MaybeConst<Member> T> void transfer(Io& io, T& v) { io(v.group); io(v.id); io(v.name); io(v.permission); }
+
+        // Event bases
+
+        template <typename Io, MaybeConst<MessageEventBase> T> void transfer(Io& io, T& v) { io(v.msg); }
+        template <typename Io, MaybeConst<GroupEventBase> T> void transfer(Io& io, T& v) { io(v.group); }
+        template <typename Io, MaybeConst<ExecutorEventBase> T> void transfer(Io& io, T& v) { io(v.executor); }
+        template <typename Io, MaybeConst<MemberEventBase> T> void transfer(Io& io, T& v) { io(v.member); }
+
+        template <typename Io, MaybeConst<GroupExecutorEventBase> T>
+        void transfer(Io& io, T& v) { io(as_base<GroupEventBase>(v)); io(v.executor); }
+
+        template <typename Io, MaybeConst<MemberExecutorEventBase> T>
+        void transfer(Io& io, T& v) { io(as_base<MemberEventBase>(v)); io(v.executor); }
+
+        // Events
+
+        template <typename Io, MaybeConst<FriendMessageEvent> T>
+        void transfer(Io& io, T& v) { io(as_base<MessageEventBase>(v)); io(v.sender); }
+        template <typename Io, MaybeConst<GroupMessageEvent> T>
+        void transfer(Io& io, T& v) { io(as_base<MessageEventBase>(v)); io(v.sender); }
+        template <typename Io, MaybeConst<TempMessageEvent> T>
+        void transfer(Io& io, T& v) { io(as_base<MessageEventBase>(v)); io(v.sender); }
+
+        template <typename Io, MaybeConst<BotOnlineEvent> T> void transfer(Io& io, T& v) { io(v.subtype); io(v.id); }
+        template <typename Io, MaybeConst<BotOfflineEvent> T> void transfer(Io& io, T& v) { io(v.subtype); io(v.id); }
+
+        template <typename Io, MaybeConst<BotGroupPermissionChangeEvent> T>
+        void transfer(Io& io, T& v) { io(as_base<GroupEventBase>(v)); io(v.original); io(v.current); }
+        template <typename Io, MaybeConst<BotMutedEvent> T>
+        void transfer(Io& io, T& v) { io(as_base<ExecutorEventBase>(v)); io(v.duration); }
+        template <typename Io, MaybeConst<BotUnmutedEvent> T>
+        void transfer(Io& io, T& v) { io(as_base<ExecutorEventBase>(v)); }
+        template <typename Io, MaybeConst<BotJoinGroupEvent> T>
+        void transfer(Io& io, T& v) { io(as_base<GroupEventBase>(v)); }
+        template <typename Io, MaybeConst<BotQuitEvent> T>
+        void transfer(Io& io, T& v) { io(as_base<GroupEventBase>(v)); }
+        template <typename Io, MaybeConst<BotKickedEvent> T>
+        void transfer(Io& io, T& v) { io(as_base<GroupEventBase>(v)); }
+
+        template <typename Io, MaybeConst<GroupRecallEvent> T>
+        void transfer(Io& io, T& v) { io(as_base<GroupExecutorEventBase>(v)); io(v.sender_id); io(v.msg_id); io(v.time); }
+        template <typename Io, MaybeConst<FriendRecallEvent> T>
+        void transfer(Io& io, T& v) { io(v.sender_id); io(v.msg_id); io(v.time); }
+
+        template <typename Io, MaybeConst<GroupNameChangeEvent> T>
+        void transfer(Io& io, T& v) { io(as_base<GroupExecutorEventBase>(v)); io(v.original); io(v.current); }
+        template <typename Io, MaybeConst<GroupEntranceAnnouncementChangeEvent> T>
+        void transfer(Io& io, T& v) { io(as_base<GroupExecutorEventBase>(v)); io(v.original); io(v.current); }
+        template <typename Io, MaybeConst<GroupConfigEvent> T>
+        void transfer(Io& io, T& v) { io(as_base<GroupExecutorEventBase>(v)); io(v.subtype); io(v.original); io(v.current); }
+
+        template <typename Io, MaybeConst<MemberJoinEvent> T>
+        void transfer(Io& io, T& v) { io(as_base<MemberEventBase>(v)); }
+        template <typename Io, MaybeConst<MemberQuitEvent> T>
+        void transfer(Io& io, T& v) { io(as_base<MemberEventBase>(v)); }
+        template <typename Io, MaybeConst<MemberKickedEvent> T>
+        void transfer(Io& io, T& v) { io(as_base<MemberExecutorEventBase>(v)); }
+        template <typename Io, MaybeConst<MemberCardChangeEvent> T>
+        void transfer(Io& io, T& v) { io(as_base<MemberExecutorEventBase>(v)); io(v.original); io(v.current); }
+        template <typename Io, MaybeConst<MemberSpecialTitleChangeEvent> T>
+        void transfer(Io& io, T& v) { io(as_base<MemberEventBase>(v)); io(v.original); io(v.current); }
+        template <typename Io, MaybeConst<MemberPermissionChangeEvent> T>
+        void transfer(Io& io, T& v) { io(as_base<MemberEventBase>(v)); io(v.original); io(v.current); }
+        template <typename Io, MaybeConst<MemberMutedEvent> T>
+        void transfer(Io& io, T& v) { io(as_base<MemberExecutorEventBase>(v)); io(v.duration); }
+        template <typename Io, MaybeConst<MemberUnmutedEvent> T>
+        void transfer(Io& io, T& v) { io(as_base<MemberExecutorEventBase>(v)); }
+
+        template <typename Io, MaybeConst<NewFriendRequestEvent> T>
+        void transfer(Io& io, T& v) { io(v.id); io(v.from_id); io(v.group_id); io(v.name); io(v.message); }
+        template <typename Io, MaybeConst<MemberJoinRequestEvent> T>
+        void transfer(Io& io, T& v) { io(v.id); io(v.from_id); io(v.group_id); io(v.group_name); io(v.name); io(v.message); }
+        template <typename Io, MaybeConst<BotInvitedJoinGroupRequestEvent> T>
+        void transfer(Io& io, T& v) { io(v.id); io(v.from_id); io(v.group_id); io(v.group_name); io(v.name); io(v.message); }
+
+        template <typename T>
+        Event read_event(Reader& r)
+        {
+            T ev;
+            r(ev);
+            return Event(std::move(ev));
+        }
+
+        Event read_event(Reader& r)
+        {
+            EventType type{};
+            r(type);
+            // @formatter:off
+            switch (type)
+            {
+                case EventType::friend_message:                     return read_event<FriendMessageEvent>(r);
+                case EventType::group_message:                      return read_event<GroupMessageEvent>(r);
+                case EventType::temp_message:                       return read_event<TempMessageEvent>(r);
+                case EventType::bot_online:                         return read_event<BotOnlineEvent>(r);
+                case EventType::bot_offline:                        return read_event<BotOfflineEvent>(r);
+                case EventType::bot_group_permission_change:        return read_event<BotGroupPermissionChangeEvent>(r);
+                case EventType::bot_muted:                          return read_event<BotMutedEvent>(r);
+                case EventType::bot_unmuted:                        return read_event<BotUnmutedEvent>(r);
+                case EventType::bot_join_group:                     return read_event<BotJoinGroupEvent>(r);
+                case EventType::bot_quit:                           return read_event<BotQuitEvent>(r);
+                case EventType::bot_kicked:                         return read_event<BotKickedEvent>(r);
+                case EventType::group_recall:                       return read_event<GroupRecallEvent>(r);
+                case EventType::friend_recall:                      return read_event<FriendRecallEvent>(r);
+                case EventType::group_name_change:                  return read_event<GroupNameChangeEvent>(r);
+                case EventType::group_entrance_announcement_change: return read_event<GroupEntranceAnnouncementChangeEvent>(r);
+                case EventType::group_config:                       return read_event<GroupConfigEvent>(r);
+                case EventType::member_join:                        return read_event<MemberJoinEvent>(r);
+                case EventType::member_quit:                        return read_event<MemberQuitEvent>(r);
+                case EventType::member_kicked:                      return read_event<MemberKickedEvent>(r);
+                case EventType::member_card_change:                 return read_event<MemberCardChangeEvent>(r);
+                case EventType::member_special_title_change:        return read_event<MemberSpecialTitleChangeEvent>(r);
+                case EventType::member_permission_change:           return read_event<MemberPermissionChangeEvent>(r);
+                case EventType::member_muted:                       return read_event<MemberMutedEvent>(r);
+                case EventType::member_unmuted:                     return read_event<MemberUnmutedEvent>(r);
+                case EventType::new_friend_request:                 return read_event<NewFriendRequestEvent>(r);
+                case EventType::member_join_request:                return read_event<MemberJoinRequestEvent>(r);
+                case EventType::bot_invited_join_group_request:     return read_event<BotInvitedJoinGroupRequestEvent>(r);
+                default: break;
+            }
+            // @formatter:on
+            throw std::runtime_error("二进制数据中的事件类型无效");
+        }
+
+        void write_header(Writer& w, const Kind kind)
+        {
+            w.byte(binary_codec_version);
+            w.byte(static_cast<uint8_t>(kind));
+        }
+
+        Reader read_header(const std::string_view data, const Kind kind)
+        {
+            Reader r(data);
+            if (r.byte() != binary_codec_version) throw std::runtime_error("二进制数据的版本不受支持");
+            if (r.byte() != static_cast<uint8_t>(kind)) throw std::runtime_error("二进制数据的内容种类不匹配");
+            return r;
+        }
+
+        template <typename T>
+        T read_all(const std::string_view data, const Kind kind)
+        {
+            Reader r = read_header(data, kind);
+            T value;
+            r(value);
+            if (!r.done()) throw std::runtime_error("二进制数据末尾有多余的内容");
+            return value;
+        }
+    }
+
+    void append_binary(std::string& out, const Message& message)
+    {
+        Writer w(out);
+        write_header(w, Kind::message);
+        w(message);
+    }
+
+    void append_binary(std::string& out, const SentMessage& message)
+    {
+        Writer w(out);
+        write_header(w, Kind::sent_message);
+        w(message);
+    }
+
+    void append_binary(std::string& out, const Event& ev)
+    {
+        Writer w(out);
+        write_header(w, Kind::event);
+        w(ev.type());
+        ev.visit([&](const auto& concrete) { w(concrete); });
+    }
+
+    Message message_from_binary(const std::string_view data) { return read_all<Message>(data, Kind::message); }
+
+    SentMessage sent_message_from_binary(const std::string_view data)
+    {
+        return read_all<SentMessage>(data, Kind::sent_message);
+    }
+
+    Event event_from_binary(const std::string_view data)
+    {
+        Reader r = read_header(data, Kind::event);
+        Event ev = read_event(r);
+        if (!r.done()) throw std::runtime_error("二进制数据末尾有多余的内容");
+        return ev;
+    }
+}
@@ -1,5 +1,10 @@
 #include "mirai/core/bot.h"
 
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <stdexcept>
 #include <thread>
 #include <simdjson.h>
 #include <clu/scope.h>
@@ -9,12 +14,17 @@
 #include <unifex/finally.hpp>
 #include <unifex/sync_wait.hpp>
 
+#include "mirai/core/binary_codec.h"
 #include "mirai/core/exceptions.h"
 #include "mirai/message/message.h"
 #include "mirai/event/event_types.h"
 
+#include "../detail/event_log.h"
 #include "../detail/json.h"
+#include "../detail/mapped_file.h"
 #include "../detail/multipart_builder.h"
+#include "../detail/recent_set.h"
+#include "../detail/stable_hash.h"
 
 namespace mpp
 {
@@ -34,12 +44,110 @@ namespace mpp
             }
         }
 
+        // Rejects a count argument that has to be positive, naming the argument and the value given
+        void check_positive(const std::string_view name, const size_t value)
+        {
+            if (value == 0) throw std::invalid_argument(fmt::format("{} must be > 0, got {}", name, value));
+        }
+
         auto get_checked_response_json(const std::string& response)
         {
             const auto json = parser.parse(response);
             check_json(json);
             return json;
         }
+
+        // Identifies a message received both through the websocket and through /fetchMessage.
+        // Message ids are only unique within a chat, so the chat is part of the key.
+        // Other events carry nothing that tells legitimate repeats apart, so they have no key
+        std::optional<uint64_t> message_dedupe_key(const Event& ev)
+        {
+            const auto key = [&](const UserId user, const GroupId group, const MessageId id)
+            {
+                detail::StableHasher hasher;
+                hasher.update(ev.type());
+                hasher.update(user.id);
+                hasher.update(group.id);
+                hasher.update(id.id);
+                return std::optional(hasher.value());
+            };
+            return ev.visit(overloaded
+            {
+                [&](const FriendMessageEvent& e) { return key(e.sender.id, {}, e.msgid()); },
+                [&](const GroupMessageEvent& e) { return key({}, e.sender.group.id, e.msgid()); },
+                [&](const TempMessageEvent& e) { return key(e.sender.id, e.sender.group.id, e.msgid()); },
+                [](const EventBase&) -> std::optional<uint64_t> { return std::nullopt; }
+            });
+        }
+
+        std::chrono::milliseconds backoff_delay(const MonitorConfig& config, const size_t attempt)
+        {
+            thread_local std::mt19937_64 rng{ std::random_device{}() };
+            const auto exp_backoff = config.initial_backoff * (int64_t{ 1 } << std::min(attempt, size_t{ 20 }));
+            const auto cap = std::min(exp_backoff, config.max_backoff);
+            std::uniform_int_distribution<int64_t> dist(cap.count() / 2, cap.count());
+            return std::chrono::milliseconds(dist(rng));
+        }
+
+        ex::task<std::optional<std::string>> read_or_closed(net::WebsocketSession& ws)
+        {
+            co_return co_await (
+                ws.read_async()
+                | ex::transform([](std::string&& text) { return std::optional(std::move(text)); })
+                | ex::transform_done([] { return ex::just(std::optional<std::string>()); })
+            );
+        }
+
+        std::span<const std::string_view> channel_paths(const MonitorChannel channel)
+        {
+            static constexpr std::string_view paths[]{ "all", "message", "event" };
+            // @formatter:off
+            switch (channel)
+            {
+                case MonitorChannel::all:      return { paths, 1 };
+                case MonitorChannel::message:  return { paths + 1, 1 };
+                case MonitorChannel::event:    return { paths + 2, 1 };
+                case MonitorChannel::separate: return { paths + 1, 2 };
+                default: throw std::runtime_error("未知的监听通道");
+            }
+            // @formatter:on
+        }
+
+        bool is_message_event(const EventType type)
+        {
+            return type == EventType::friend_message || type == EventType::group_message || type == EventType::temp_message;
+        }
+
+        bool channel_accepts(const MonitorChannel channel, const EventType type)
+        {
+            // @formatter:off
+            switch (channel)
+            {
+                case MonitorChannel::message: return is_message_event(type);
+                case MonitorChannel::event:   return !is_message_event(type);
+                default: return true;
+            }
+            // @formatter:on
+        }
+
+        ex::task<void> close_quietly(net::WebsocketSession& ws)
+        {
+            try { co_await ws.close_async(); }
+            catch (...) {} // The connection may already be broken
+        }
+
+        SentMessage message_content(Event&& ev)
+        {
+            // @formatter:off
+            switch (ev.type())
+            {
+                case EventType::friend_message: return std::move(ev.get<FriendMessageEvent>().msg);
+                case EventType::group_message:  return std::move(ev.get<GroupMessageEvent>().msg);
+                case EventType::temp_message:   return std::move(ev.get<TempMessageEvent>().msg);
+                default: throw std::runtime_error("获取到的事件不是消息事件");
+            }
+            // @formatter:on
+        }
     }
 
     // Request body
@@ -123,17 +231,46 @@ namespace mpp
             });
         }
 
-        std::string upload_file_body(const Bot* bot,
-            const TargetType type, const std::string_view key, const std::filesystem::path& path)
+        // The file content is sent straight from the caller's buffer instead of being copied into the body
+        class UploadFileBody final
         {
-            using detail::MultipartBuilder;
+        private:
+            detail::MultipartBuilder builder_;
+            std::vector<std::string_view> parts_;
 
-            MultipartBuilder builder;
-            builder.add_key_value("sessionKey", bot->session_key());
-            builder.add_key_value("type", to_string_view(type));
-            builder.add_file(key, path);
+        public:
+            UploadFileBody(const Bot* bot, const TargetType type,
+                const std::string_view key, const std::string_view filename, const std::string_view content)
+            {
+                builder_.add_key_value("sessionKey", bot->session_key());
+                builder_.add_key_value("type", to_string_view(type));
+                builder_.add_file_view(key, filename, content);
+                parts_ = builder_.take_parts();
+            }
+
+            UploadFileBody(const UploadFileBody&) = delete;
+            UploadFileBody& operator=(const UploadFileBody&) = delete;
 
-            return builder.take_string();
+            std::span<const std::string_view> parts() const noexcept { return parts_; }
+        };
+
+        template <typename T>
+        std::optional<T> find_uploaded(const UploadCache& cache, const TargetType type, const std::string_view content)
+        {
+            if constexpr (std::is_same_v<T, Image>)
+                return cache.find_image(type, content);
+            else
+                return cache.find_voice(type, content);
+        }
+
+        void add_uploaded(UploadCache& cache, const TargetType type, const std::string_view content, const Image& image)
+        {
+            cache.add_image(type, content, image);
+        }
+
+        void add_uploaded(UploadCache& cache, const TargetType type, const std::string_view content, const Voice& voice)
+        {
+            cache.add_voice(type, content, voice);
         }
 
         std::string config_body(const Bot* bot, const SessionConfig config)
@@ -257,10 +394,24 @@ namespace mpp
         return fmt::format(R"({{"authKey":{}}})", detail::JsonQuoted{ auth_key });
     }
 
+    ex::task<std::string> Bot::http_get_shared_async(std::string target)
+    {
+        const auto request = [&] { return net_client_.http_get_async(target); };
+        co_return co_await single_flight_.run(target, request);
+    }
+
     Event Bot::parse_event(const detail::JsonElem json)
     {
         Event ev = Event::from_json(json);
         ev.event_base().bot_ = this;
+        observe_event(ev);
+        return ev;
+    }
+
+    Event Bot::decode_event(const std::string_view data)
+    {
+        Event ev = event_from_binary(data);
+        ev.event_base().bot_ = this;
         return ev;
     }
 
@@ -272,6 +423,19 @@ namespace mpp
         return events;
     }
 
+    void Bot::observe_event(const Event& ev)
+    {
+        if (const auto cache = roster_.load()) cache->update(ev);
+        if (const auto store = message_store_.load()) store->add(ev);
+    }
+
+    void Bot::remember_sent_message(const MessageId id, const Message& message, const clu::optional_param<MessageId> quote)
+    {
+        const auto store = message_store_.load();
+        if (!store) return;
+        store->add_sent(id, message, quote ? std::optional(MessageId(quote->id)) : std::nullopt);
+    }
+
     Bot::~Bot() noexcept
     {
         try
@@ -336,21 +500,27 @@ namespace mpp
     {
         const auto res = get_checked_response_json(
             net_client_.http_post_json("/sendFriendMessage", send_message_body(this, id.id, message, quote)));
-        return MessageId(detail::from_json<int32_t>(res["messageId"]));
+        const MessageId msgid(detail::from_json<int32_t>(res["messageId"]));
+        remember_sent_message(msgid, message, quote);
+        return msgid;
     }
 
     MessageId Bot::send_message(const GroupId id, const Message& message, const clu::optional_param<MessageId> quote)
     {
         const auto res = get_checked_response_json(
             net_client_.http_post_json("/sendGroupMessage", send_message_body(this, id.id, message, quote)));
-        return MessageId(detail::from_json<int32_t>(res["messageId"]));
+        const MessageId msgid(detail::from_json<int32_t>(res["messageId"]));
+        remember_sent_message(msgid, message, quote);
+        return msgid;
     }
 
     MessageId Bot::send_message(const TempId id, const Message& message, const clu::optional_param<MessageId> quote)
     {
         const auto res = get_checked_response_json(
             net_client_.http_post_json("/sendTempMessage", send_message_body(this, id, message, quote)));
-        return MessageId(detail::from_json<int32_t>(res["messageId"]));
+        const MessageId msgid(detail::from_json<int32_t>(res["messageId"]));
+        remember_sent_message(msgid, message, quote);
+        return msgid;
     }
 
     ex::task<MessageId> Bot::send_message_async(
@@ -358,7 +528,9 @@ namespace mpp
     {
         const auto res = get_checked_response_json(
             co_await net_client_.http_post_json_async("/sendFriendMessage", send_message_body(this, id.id, message, quote)));
-        co_return MessageId(detail::from_json<int32_t>(res["messageId"]));
+        const MessageId msgid(detail::from_json<int32_t>(res["messageId"]));
+        remember_sent_message(msgid, message, quote);
+        co_return msgid;
     }
 
     ex::task<MessageId> Bot::send_message_async(
@@ -366,7 +538,9 @@ namespace mpp
     {
         const auto res = get_checked_response_json(
             co_await net_client_.http_post_json_async("/sendGroupMessage", send_message_body(this, id.id, message, quote)));
-        co_return MessageId(detail::from_json<int32_t>(res["messageId"]));
+        const MessageId msgid(detail::from_json<int32_t>(res["messageId"]));
+        remember_sent_message(msgid, message, quote);
+        co_return msgid;
     }
 
     ex::task<MessageId> Bot::send_message_async(
@@ -374,7 +548,9 @@ namespace mpp
     {
         const auto res = get_checked_response_json(
             co_await net_client_.http_post_json_async("/sendTempMessage", send_message_body(this, id, message, quote)));
-        co_return MessageId(detail::from_json<int32_t>(res["messageId"]));
+        const MessageId msgid(detail::from_json<int32_t>(res["messageId"]));
+        remember_sent_message(msgid, message, quote);
+        co_return msgid;
     }
 
     void Bot::recall(const MessageId id)
@@ -434,64 +610,188 @@ namespace mpp
         co_return detail::from_json<std::vector<std::string>>(json);
     }
 
+    void Bot::enable_upload_cache(const std::filesystem::path& index_path)
+    {
+        upload_cache_.store(index_path.empty()
+            ? std::make_shared<UploadCache>()
+            : std::make_shared<UploadCache>(index_path));
+    }
+
+    template <typename T>
+    T Bot::upload_content(const TargetType type, const std::string_view filename, const std::string_view content)
+    {
+        constexpr bool is_image = std::is_same_v<T, Image>;
+        const auto cache = upload_cache_.load();
+        if (cache)
+            if (auto cached = find_uploaded<T>(*cache, type, content))
+                return std::move(*cached);
+        const UploadFileBody body(this, type, is_image ? "img" : "voice", filename, content);
+        auto res = get_checked_response_json(net_client_.http_post_parts(
+            is_image ? "/uploadImage" : "/uploadVoice", detail::MultipartBuilder::content_type, body.parts()));
+        T result = T::from_json(res.value());
+        if (cache) add_uploaded(*cache, type, content, result);
+        return result;
+    }
+
+    template <typename T>
+    ex::task<T> Bot::upload_content_async(const TargetType type, const std::string_view filename, const std::string_view content)
+    {
+        constexpr bool is_image = std::is_same_v<T, Image>;
+        const auto cache = upload_cache_.load();
+        if (cache)
+            if (auto cached = find_uploaded<T>(*cache, type, content))
+                co_return std::move(*cached);
+        const UploadFileBody body(this, type, is_image ? "img" : "voice", filename, content);
+        auto res = get_checked_response_json(co_await net_client_.http_post_parts_async(
+            is_image ? "/uploadImage" : "/uploadVoice", detail::MultipartBuilder::content_type, body.parts()));
+        T result = T::from_json(res.value());
+        if (cache) add_uploaded(*cache, type, content, result);
+        co_return result;
+    }
+
+    template <typename T, typename Item>
+    ex::task<std::vector<clu::outcome<T>>> Bot::upload_batch_async(const TargetType type,
+        const std::span<const Item> items, const size_t max_concurrency)
+    {
+        check_positive("max_concurrency", max_concurrency);
+
+        const auto upload_one = [&](const Item& item) -> ex::task<T>
+        {
+            if constexpr (std::is_same_v<Item, std::filesystem::path>)
+            {
+                const detail::MappedFile file(item);
+                co_return co_await upload_content_async<T>(type, item.filename().string(), file.view());
+            }
+            else
+                co_return co_await upload_content_async<T>(type, std::is_same_v<T, Image> ? "image" : "voice", item);
+        };
+
+        std::vector<clu::outcome<T>> results(items.size());
+        std::atomic_size_t next = 0;
+        const auto worker = [&]() -> ex::task<void>
+        {
+            // Each worker keeps taking the next item until all items are taken
+            for (size_t i = next++; i < items.size(); i = next++)
+            {
+                try { results[i] = co_await upload_one(items[i]); }
+                catch (...) { results[i] = std::current_exception(); }
+            }
+        };
+
+        const auto stop_token = co_await ex::get_stop_token();
+        ex::async_scope scope;
+        const auto stop_callback = detail::make_stop_callback(stop_token, [&] { scope.request_stop(); });
+        const size_t worker_count = std::min(max_concurrency, items.size());
+        for (size_t i = 0; i < worker_count; i++)
+            scope.spawn(worker(), get_scheduler());
+        co_await scope.complete();
+
+        if (stop_token.stop_requested()) co_await ex::stop();
+        co_return results;
+    }
+
     Image Bot::upload_image(const TargetType type, const std::filesystem::path& path)
     {
-        auto res = get_checked_response_json(net_client_.http_post(
-            "/uploadImage", detail::MultipartBuilder::content_type,
-            upload_file_body(this, type, "img", path)));
-        return Image::from_json(res.value());
+        const detail::MappedFile file(path);
+        return upload_content<Image>(type, path.filename().string(), file.view());
     }
 
     ex::task<Image> Bot::upload_image_async(const TargetType type, const std::filesystem::path& path)
     {
-        auto res = get_checked_response_json(co_await net_client_.http_post_async(
-            "/uploadImage", detail::MultipartBuilder::content_type,
-            upload_file_body(this, type, "img", path)));
-        co_return Image::from_json(res.value());
+        const detail::MappedFile file(path);
+        co_return co_await upload_content_async<Image>(type, path.filename().string(), file.view());
+    }
+
+    Image Bot::upload_image_data(const TargetType type, const std::string_view data)
+    {
+        return upload_content<Image>(type, "image", data);
+    }
+
+    ex::task<Image> Bot::upload_image_data_async(const TargetType type, const std::string_view data)
+    {
+        return upload_content_async<Image>(type, "image", data);
+    }
+
+    ex::task<std::vector<clu::outcome<Image>>> Bot::upload_images_async(const TargetType type,
+        const std::span<const std::filesystem::path> paths, const size_t max_concurrency)
+    {
+        return upload_batch_async<Image>(type, paths, max_concurrency);
+    }
+
+    ex::task<std::vector<clu::outcome<Image>>> Bot::upload_images_data_async(const TargetType type,
+        const std::span<const std::string_view> data, const size_t max_concurrency)
+    {
+        return upload_batch_async<Image>(type, data, max_concurrency);
     }
 
     Voice Bot::upload_voice(const TargetType type, const std::filesystem::path& path)
     {
-        auto res = get_checked_response_json(net_client_.http_post(
-            "/uploadVoice", detail::MultipartBuilder::content_type,
-            upload_file_body(this, type, "voice", path)));
-        return Voice::from_json(res.value());
+        const detail::MappedFile file(path);
+        return upload_content<Voice>(type, path.filename().string(), file.view());
     }
 
     ex::task<Voice> Bot::upload_voice_async(const TargetType type, const std::filesystem::path& path)
     {
-        auto res = get_checked_response_json(co_await net_client_.http_post_async(
-            "/uploadVoice", detail::MultipartBuilder::content_type,
-            upload_file_body(this, type, "voice", path)));
-        co_return Voice::from_json(res.value());
+        const detail::MappedFile file(path);
+        co_return co_await upload_content_async<Voice>(type, path.filename().string(), file.view());
+    }
+
+    Voice Bot::upload_voice_data(const TargetType type, const std::string_view data)
+    {
+        return upload_content<Voice>(type, "voice", data);
+    }
+
+    ex::task<Voice> Bot::upload_voice_data_async(const TargetType type, const std::string_view data)
+    {
+        return upload_content_async<Voice>(type, "voice", data);
+    }
+
+    ex::task<std::vector<clu::outcome<Voice>>> Bot::upload_voices_async(const TargetType type,
+        const std::span<const std::filesystem::path> paths, const size_t max_concurrency)
+    {
+        return upload_batch_async<Voice>(type, paths, max_concurrency);
+    }
+
+    ex::task<std::vector<clu::outcome<Voice>>> Bot::upload_voices_data_async(const TargetType type,
+        const std::span<const std::string_view> data, const size_t max_concurrency)
+    {
+        return upload_batch_async<Voice>(type, data, max_concurrency);
     }
 
     std::vector<Event> Bot::pop_events(const size_t count)
     {
         const auto json = get_checked_response_json(net_client_.http_get(
             fmt::format("/fetchMessage?sessionKey={}&count={}", sess_key_, count)));
-        return parse_events(json["data"]);
+        auto events = parse_events(json["data"]);
+        for (const Event& ev : events) observe_event(ev);
+        return events;
     }
 
     ex::task<std::vector<Event>> Bot::pop_events_async(const size_t count)
     {
         const auto json = get_checked_response_json(co_await net_client_.http_get_async(
             fmt::format("/fetchMessage?sessionKey={}&count={}", sess_key_, count)));
-        co_return parse_events(json["data"]);
+        auto events = parse_events(json["data"]);
+        for (const Event& ev : events) observe_event(ev);
+        co_return events;
     }
 
     std::vector<Event> Bot::pop_latest_events(const size_t count)
     {
         const auto json = get_checked_response_json(net_client_.http_get(
             fmt::format("/fetchLatestMessage?sessionKey={}&count={}", sess_key_, count)));
-        return parse_events(json["data"]);
+        auto events = parse_events(json["data"]);
+        for (const Event& ev : events) observe_event(ev);
+        return events;
     }
 
     ex::task<std::vector<Event>> Bot::pop_latest_events_async(const size_t count)
     {
         const auto json = get_checked_response_json(co_await net_client_.http_get_async(
             fmt::format("/fetchLatestMessage?sessionKey={}&count={}", sess_key_, count)));
-        co_return parse_events(json["data"]);
+        auto events = parse_events(json["data"]);
+        for (const Event& ev : events) observe_event(ev);
+        co_return events;
     }
 
     std::vector<Event> Bot::peek_events(const size_t count)
@@ -522,8 +822,16 @@ namespace mpp
         co_return parse_events(json["data"]);
     }
 
+    void Bot::enable_message_store(const size_t capacity, const size_t byte_budget)
+    {
+        message_store_.store(std::make_shared<MessageStore>(capacity, byte_budget));
+    }
+
     Event Bot::retrieve_message(const MessageId id)
     {
+        if (const auto store = message_store_.load())
+            if (auto ev = store->find_event(id))
+                return std::move(*ev);
         const auto json = get_checked_response_json(net_client_.http_get(
             fmt::format("/messageFromId?sessionKey={}&id={}", sess_key_, id.id)));
         return Event::from_json(json["data"]);
@@ -531,11 +839,30 @@ namespace mpp
 
     ex::task<Event> Bot::retrieve_message_async(const MessageId id)
     {
+        if (const auto store = message_store_.load())
+            if (auto ev = store->find_event(id))
+                co_return std::move(*ev);
         const auto json = get_checked_response_json(co_await net_client_.http_get_async(
             fmt::format("/messageFromId?sessionKey={}&id={}", sess_key_, id.id)));
         co_return Event::from_json(json["data"]);
     }
 
+    SentMessage Bot::retrieve_message_content(const MessageId id)
+    {
+        if (const auto store = message_store_.load())
+            if (auto msg = store->find_message(id))
+                return std::move(*msg);
+        return message_content(retrieve_message(id));
+    }
+
+    ex::task<SentMessage> Bot::retrieve_message_content_async(const MessageId id)
+    {
+        if (const auto store = message_store_.load())
+            if (auto msg = store->find_message(id))
+                co_return std::move(*msg);
+        co_return message_content(co_await retrieve_message_async(id));
+    }
+
     size_t Bot::count_message()
     {
         const auto json = get_checked_response_json(net_client_.http_get(
@@ -550,46 +877,159 @@ namespace mpp
         co_return detail::from_json<size_t>(json["data"]);
     }
 
+    namespace
+    {
+        // Events arriving during the request are replayed on top of the fetched list
+        std::optional<RosterCache::Fetch> begin_fetch(const std::shared_ptr<RosterCache>& cache)
+        {
+            if (!cache) return std::nullopt;
+            return cache->begin_fetch();
+        }
+    }
+
+    void Bot::enable_roster_cache(const Clock::duration max_age)
+    {
+        roster_.store(std::make_shared<RosterCache>(max_age));
+    }
+
+    void Bot::refresh_roster()
+    {
+        const auto cache = roster_.load();
+        if (!cache) return;
+        cache->invalidate();
+        (void)list_friends();
+        (void)list_groups();
+    }
+
+    ex::task<void> Bot::refresh_roster_async()
+    {
+        const auto cache = roster_.load();
+        if (!cache) co_return;
+        cache->invalidate();
+        (void)co_await list_friends_async();
+        (void)co_await list_groups_async();
+    }
+
     std::vector<Friend> Bot::list_friends()
     {
+        const auto cache = roster_.load();
+        if (cache)
+            if (auto friends = cache->friends())
+                return std::move(*friends);
+        const auto fetch = begin_fetch(cache);
         const auto json = get_checked_response_json(net_client_.http_get(
             fmt::format("/friendList?sessionKey={}", sess_key_)));
-        return detail::from_json<std::vector<Friend>>(json);
+        auto friends = detail::from_json<std::vector<Friend>>(json);
+        if (cache) cache->set_friends(friends, *fetch);
+        return friends;
     }
 
     ex::task<std::vector<Friend>> Bot::list_friends_async()
     {
-        const auto json = get_checked_response_json(co_await net_client_.http_get_async(
+        const auto cache = roster_.load();
+        if (cache)
+            if (auto friends = cache->friends())
+                co_return std::move(*friends);
+        const auto fetch = begin_fetch(cache);
+        const auto json = get_checked_response_json(co_await http_get_shared_async(
             fmt::format("/friendList?sessionKey={}", sess_key_)));
-        co_return detail::from_json<std::vector<Friend>>(json);
+        auto friends = detail::from_json<std::vector<Friend>>(json);
+        if (cache) cache->set_friends(friends, *fetch);
+        co_return friends;
     }
 
     std::vector<Group> Bot::list_groups()
     {
+        const auto cache = roster_.load();
+        if (cache)
+            if (auto groups = cache->groups())
+                return std::move(*groups);
+        const auto fetch = begin_fetch(cache);
         const auto json = get_checked_response_json(net_client_.http_get(
             fmt::format("/groupList?sessionKey={}", sess_key_)));
-        return detail::from_json<std::vector<Group>>(json);
+        auto groups = detail::from_json<std::vector<Group>>(json);
+        if (cache) cache->set_groups(groups, *fetch);
+        return groups;
     }
 
     ex::task<std::vector<Group>> Bot::list_groups_async()
     {
-        const auto json = get_checked_response_json(co_await net_client_.http_get_async(
+        const auto cache = roster_.load();
+        if (cache)
+            if (auto groups = cache->groups())
+                co_return std::move(*groups);
+        const auto fetch = begin_fetch(cache);
+        const auto json = get_checked_response_json(co_await http_get_shared_async(
             fmt::format("/groupList?sessionKey={}", sess_key_)));
-        co_return detail::from_json<std::vector<Group>>(json);
+        auto groups = detail::from_json<std::vector<Group>>(json);
+        if (cache) cache->set_groups(groups, *fetch);
+        co_return groups;
     }
 
     std::vector<Member> Bot::list_members(const GroupId id)
     {
+        const auto cache = roster_.load();
+        if (cache)
+            if (auto members = cache->members(id))
+                return std::move(*members);
+        const auto fetch = begin_fetch(cache);
         const auto json = get_checked_response_json(net_client_.http_get(
             fmt::format("/memberList?sessionKey={}&target={}", sess_key_, id.id)));
-        return detail::from_json<std::vector<Member>>(json);
+        auto members = detail::from_json<std::vector<Member>>(json);
+        if (cache) cache->set_members(id, members, *fetch);
+        return members;
     }
 
     ex::task<std::vector<Member>> Bot::list_members_async(const GroupId id)
     {
-        const auto json = get_checked_response_json(co_await net_client_.http_get_async(
+        const auto cache = roster_.load();
+        if (cache)
+            if (auto members = cache->members(id))
+                co_return std::move(*members);
+        const auto fetch = begin_fetch(cache);
+        const auto json = get_checked_response_json(co_await http_get_shared_async(
             fmt::format("/memberList?sessionKey={}&target={}", sess_key_, id.id)));
-        co_return detail::from_json<std::vector<Member>>(json);
+        auto members = detail::from_json<std::vector<Member>>(json);
+        if (cache) cache->set_members(id, members, *fetch);
+        co_return members;
+    }
+
+    namespace
+    {
+        MemberRoster member_roster_from_json(detail::JsonRes json, const GroupId id)
+        {
+            MemberRoster roster = MemberRoster::from_json(json.value());
+            if (roster.empty()) return MemberRoster(Group{ .id = id });
+            return roster;
+        }
+    }
+
+    MemberRoster Bot::get_member_roster(const GroupId id)
+    {
+        const auto cache = roster_.load();
+        if (cache)
+            if (auto members = cache->members(id); members && !members->empty())
+                return MemberRoster(*members);
+        const auto fetch = begin_fetch(cache);
+        const auto json = get_checked_response_json(net_client_.http_get(
+            fmt::format("/memberList?sessionKey={}&target={}", sess_key_, id.id)));
+        MemberRoster roster = member_roster_from_json(json, id);
+        if (cache) cache->set_members(id, roster.to_members(), *fetch);
+        return roster;
+    }
+
+    ex::task<MemberRoster> Bot::get_member_roster_async(const GroupId id)
+    {
+        const auto cache = roster_.load();
+        if (cache)
+            if (auto members = cache->members(id); members && !members->empty())
+                co_return MemberRoster(*members);
+        const auto fetch = begin_fetch(cache);
+        const auto json = get_checked_response_json(co_await http_get_shared_async(
+            fmt::format("/memberList?sessionKey={}&target={}", sess_key_, id.id)));
+        MemberRoster roster = member_roster_from_json(json, id);
+        if (cache) cache->set_members(id, roster.to_members(), *fetch);
+        co_return roster;
     }
 
     void Bot::mute(const GroupId group, const UserId user, const std::chrono::seconds duration)
@@ -715,7 +1155,7 @@ namespace mpp
 
     ex::task<GroupConfig> Bot::get_group_config_async(const GroupId group)
     {
-        const auto json = get_checked_response_json(co_await net_client_.http_get_async(
+        const auto json = get_checked_response_json(co_await http_get_shared_async(
             fmt::format("/groupConfig?sessionKey={}&target={}", sess_key_, group.id)));
         co_return detail::from_json<GroupConfig>(json);
     }
@@ -734,16 +1174,30 @@ namespace mpp
 
     MemberInfo Bot::get_member_info(GroupId group, UserId user)
     {
+        const auto cache = roster_.load();
+        if (cache)
+            if (auto info = cache->find_member_info(group, user))
+                return std::move(*info);
+        const auto fetch = begin_fetch(cache);
         const auto json = get_checked_response_json(net_client_.http_get(
             fmt::format("/groupConfig?sessionKey={}&target={}&memberId={}", sess_key_, group.id, user.id)));
-        return detail::from_json<MemberInfo>(json);
+        auto info = detail::from_json<MemberInfo>(json);
+        if (cache) cache->set_member_info(group, user, info, *fetch);
+        return info;
     }
 
     ex::task<MemberInfo> Bot::get_member_info_async(const GroupId group, const UserId user)
     {
-        const auto json = get_checked_response_json(co_await net_client_.http_get_async(
+        const auto cache = roster_.load();
+        if (cache)
+            if (auto info = cache->find_member_info(group, user))
+                co_return std::move(*info);
+        const auto fetch = begin_fetch(cache);
+        const auto json = get_checked_response_json(co_await http_get_shared_async(
             fmt::format("/groupConfig?sessionKey={}&target={}&memberId={}", sess_key_, group.id, user.id)));
-        co_return detail::from_json<MemberInfo>(json);
+        auto info = detail::from_json<MemberInfo>(json);
+        if (cache) cache->set_member_info(group, user, info, *fetch);
+        co_return info;
     }
 
     void Bot::set_member_info(const GroupId group, const UserId user, const MemberInfo& info)
@@ -762,8 +1216,17 @@ namespace mpp
         const clu::function_ref<bool(const Event&)> callback,
         const clu::function_ref<void()> exception_handler)
     {
+        monitor_events(callback, MonitorChannel::all, exception_handler);
+    }
+
+    void Bot::monitor_events(
+        const clu::function_ref<bool(const Event&)> callback, const MonitorChannel channel,
+        const clu::function_ref<void()> exception_handler)
+    {
+        const auto paths = channel_paths(channel);
+        if (paths.size() != 1) throw std::runtime_error("同步监听不支持同时连接多个通道");
         net::WebsocketSession ws = net_client_.new_websocket_session();
-        net_client_.connect_websocket(ws, fmt::format("/all?sessionKey={}", sess_key_));
+        net_client_.connect_websocket(ws, fmt::format("/{}?sessionKey={}", paths.front(), sess_key_));
         clu::scope_exit _([&] { ws.close(); });
 
         while (true)
@@ -778,41 +1241,465 @@ namespace mpp
         }
     }
 
-    ex::task<void> Bot::monitor_events_async(
-        const clu::function_ref<ex::task<void>(const Event&)> callback,
+    ex::task<void> Bot::dispatch_event_async(Event ev,
+        const clu::function_ref<ex::task<void>(Event&&)> callback,
+        const clu::function_ref<void()> exception_handler, const clu::function_ref<void()> on_stop)
+    {
+        try
+        {
+            if (co_await queue_.filter_event(ev)) co_return;
+            co_await (
+                callback(std::move(ev))
+                | ex::transform_done([&] { on_stop(); return ex::just(); })
+            );
+        }
+        catch (...) { exception_handler(); }
+    }
+
+    ex::task<void> Bot::poll_events_async(
+        const clu::function_ref<ex::task<void>(const Event&)> callback, const PollConfig config,
         const clu::function_ref<void()> exception_handler)
     {
-        const auto stop_token = co_await ex::get_stop_token();
-        net::WebsocketSession ws = net_client_.new_websocket_session();
-        co_await net_client_.connect_websocket_async(ws, fmt::format("/all?sessionKey={}", sess_key_));
+        check_positive("config.batch_size", config.batch_size);
+        const auto forward = [&](Event&& ev) { return callback(ev); };
 
+        const auto stop_token = co_await ex::get_stop_token();
         ex::async_scope scope;
-        const auto stop_callback = detail::make_stop_callback(stop_token,
-            [&] { scope.spawn(ws.close_async(), get_scheduler()); });
+        std::atomic_bool closing = false;
+        const auto request_close = [&] { closing = true; };
 
         const auto work = [&]() -> ex::task<void>
         {
-            while (true)
+            Clock::duration interval = config.min_interval;
+            while (!closing)
             {
+                size_t count = 0;
                 try
                 {
-                    auto json = parser.parse(co_await ws.read_async());
-                    check_json(json);
-                    scope.spawn([&](Event ev) -> ex::task<void>
+                    const auto json = get_checked_response_json(co_await net_client_.http_get_async(
+                        fmt::format("/fetchMessage?sessionKey={}&count={}", sess_key_, config.batch_size)));
+                    for (const auto elem : json["data"])
                     {
+                        count++;
                         try
                         {
-                            if (co_await queue_.filter_event(ev)) co_return;
-                            co_await (
-                                callback(ev)
-                                | ex::transform_done([&] { return ws.close_async(); })
-                            );
+                            // The dispatch runs in the background, so the next batch is fetched in the meantime
+                            scope.spawn(dispatch_event_async(parse_event(elem),
+                                forward, exception_handler, request_close), get_scheduler());
                         }
                         catch (...) { exception_handler(); }
-                    }(parse_event(json.value())), get_scheduler());
+                    }
+                }
+                catch (const MiraiException&) { throw; }
+                catch (...)
+                {
+                    exception_handler();
+                    interval = config.max_interval;
+                }
+
+                // A full batch means more events are waiting, so poll again right away;
+                // otherwise the interval shrinks while events keep coming and grows while it is quiet
+                if (count == config.batch_size) continue;
+                if (count == 0)
+                    interval = std::min<Clock::duration>(interval * 2, config.max_interval);
+                else
+                    interval = std::max<Clock::duration>(interval / 2, config.min_interval);
+                co_await wait_async(interval);
+            }
+        };
+
+        co_await (
+            work()
+            | ex::finally(
+                ex::sequence(scope.cleanup(), queue_.cleanup())
+                | ex::on(get_scheduler()))
+            | ex::transform_done([] { return ex::just(); })
+        );
+
+        if (stop_token.stop_requested()) co_await ex::stop();
+    }
+
+    ex::task<void> Bot::monitor_webhook_async(const std::string_view address, const uint16_t port,
+        const clu::function_ref<ex::task<void>(const Event&)> callback,
+        const clu::function_ref<void()> exception_handler)
+    {
+        const auto stop_token = co_await ex::get_stop_token();
+        ex::async_scope scope;
+        net::WebhookServer server = net_client_.new_webhook_server(address, port);
+        const auto request_close = [&] { server.close(); };
+        const auto forward = [&](Event&& ev) { return callback(ev); };
+
+        // Called on the network threads, the dispatches are spawned so that the response is sent right away
+        const auto handle = [&](const std::string body)
+        {
+            try
+            {
+                auto json = parser.parse(body);
+                const auto spawn = [&](const detail::JsonElem elem)
+                {
+                    scope.spawn(dispatch_event_async(parse_event(elem),
+                        forward, exception_handler, request_close), get_scheduler());
+                };
+                if (const detail::JsonElem elem = json.value(); elem.is_array())
+                    for (const auto item : elem.get_array()) spawn(item);
+                else
+                    spawn(elem);
+            }
+            catch (...)
+            {
+                exception_handler();
+                throw;
+            }
+        };
+
+        co_await (
+            server.serve_async(handle)
+            | ex::finally(
+                ex::sequence(scope.cleanup(), queue_.cleanup())
+                | ex::on(get_scheduler()))
+            | ex::transform_done([] { return ex::just(); })
+        );
+
+        if (stop_token.stop_requested()) co_await ex::stop();
+    }
+
+    ex::task<void> Bot::monitor_event_batches_async(
+        const clu::function_ref<ex::task<void>(std::span<const Event>)> callback,
+        const BatchConfig batch, const MonitorConfig config, const clu::function_ref<void()> exception_handler)
+    {
+        check_positive("batch.max_size", batch.max_size);
+
+        const auto stop_token = co_await ex::get_stop_token();
+        std::mutex mutex;
+        std::vector<Event> pending;
+        pending.reserve(batch.max_size);
+        ex::async_mutex delivery; // Batches are delivered one at a time, in the order they are taken
+        std::atomic_bool stopping = false;
+        std::atomic_bool monitoring = true;
+
+        const auto flush = [&]() -> ex::task<void>
+        {
+            co_await delivery.async_lock();
+            std::vector<Event> events;
+            {
+                std::unique_lock lock(mutex);
+                events.swap(pending);
+                pending.reserve(batch.max_size);
+            }
+            try
+            {
+                // More events than a batch may have piled up while the previous batch was being handled
+                const std::span<const Event> all = events;
+                for (size_t i = 0; i < all.size() && !stopping; i += batch.max_size)
+                    co_await (
+                        callback(all.subspan(i, std::min(batch.max_size, all.size() - i)))
+                        | ex::transform_done([&] { stopping = true; return ex::just(); })
+                    );
+            }
+            catch (...)
+            {
+                delivery.unlock();
+                throw;
+            }
+            delivery.unlock();
+        };
+
+        const auto collect = [&](Event&& ev) -> ex::task<void>
+        {
+            if (stopping) co_await ex::stop();
+            bool full = false;
+            {
+                std::unique_lock lock(mutex);
+                pending.push_back(std::move(ev));
+                full = pending.size() >= batch.max_size;
+            }
+            if (full) co_await flush();
+            if (stopping) co_await ex::stop();
+        };
+
+        const auto monitor = [&]() -> ex::task<void>
+        {
+            co_await monitor_owned_events_async(collect, config, exception_handler);
+            monitoring = false;
+        };
+
+        const auto tick = [&]() -> ex::task<void>
+        {
+            while (monitoring)
+            {
+                co_await wait_async(std::chrono::duration_cast<Clock::duration>(batch.max_delay));
+                try { co_await flush(); }
+                catch (...) { exception_handler(); }
+                // Stopping the ticks also cancels the monitor when no event arrives to notice the request
+                if (stopping) co_await ex::stop();
+            }
+        };
+
+        co_await (
+            ex::when_all(monitor(), tick())
+            | ex::transform([](auto&&...) {})
+            | ex::transform_done([] { return ex::just(); })
+        );
+
+        if (!stopping)
+        {
+            try { co_await flush(); }
+            catch (...) { exception_handler(); }
+        }
+        if (stop_token.stop_requested()) co_await ex::stop();
+    }
+
+    ex::task<void> Bot::monitor_events_async(
+        const clu::function_ref<ex::task<void>(const Event&)> callback,
+        const clu::function_ref<void()> exception_handler)
+    {
+        return monitor_events_async(callback,
+            MonitorConfig{ .auto_reconnect = false, .backfill = false, .heartbeat_interval = {} }, exception_handler);
+    }
+
+    ex::task<void> Bot::monitor_events_async(
+        const clu::function_ref<ex::task<void>(const Event&)> callback, const MonitorConfig config,
+        const clu::function_ref<void()> exception_handler)
+    {
+        const auto forward = [&](Event&& ev) { return callback(ev); };
+        co_await monitor_owned_events_async(forward, config, exception_handler);
+    }
+
+    ex::task<void> Bot::monitor_shared_events_async(
+        const clu::function_ref<ex::task<void>(SharedEvent)> callback, const MonitorConfig config,
+        const clu::function_ref<void()> exception_handler)
+    {
+        // The event is moved into the shared state after the filters had their chance to take it
+        const auto share = [&](Event&& ev) { return callback(SharedEvent(std::move(ev))); };
+        co_await monitor_owned_events_async(share, config, exception_handler);
+    }
+
+    ex::task<void> Bot::monitor_owned_events_async(
+        const clu::function_ref<ex::task<void>(Event&&)> callback, const MonitorConfig config,
+        const clu::function_ref<void()> exception_handler)
+    {
+        if (config.heartbeat_interval.count() > 0 && config.heartbeat_timeout <= config.heartbeat_interval)
+            throw std::invalid_argument("心跳超时时长必须大于发送 ping 的间隔");
+        const auto stop_token = co_await ex::get_stop_token();
+        ex::async_scope scope;
+
+        // Each lane is a websocket connection to one channel, which is replaced on reconnection
+        struct Lane
+        {
+            std::string target;
+            std::mutex mutex;
+            std::optional<net::WebsocketSession> ws;
+        };
+        std::deque<Lane> lanes;
+        for (const std::string_view channel : channel_paths(config.channel))
+            lanes.emplace_back().target = fmt::format("/{}?sessionKey={}", channel, sess_key_);
+
+        // Closing is only ever requested once and ends the monitor
+        std::atomic_bool closing = false;
+        const auto request_close = [&]
+        {
+            if (closing.exchange(true)) return;
+            for (Lane& lane : lanes)
+            {
+                std::unique_lock lock(lane.mutex);
+                if (lane.ws) scope.spawn(close_quietly(*lane.ws), get_scheduler());
+            }
+        };
+        const auto stop_callback = detail::make_stop_callback(stop_token, request_close);
+
+        std::optional<detail::EventLogWriter> recorder;
+        if (!config.record_path.empty()) recorder.emplace(config.record_path);
+
+        std::mutex delivered_mutex;
+        detail::RecentSet delivered(config.backfill ? config.dedupe_window : 0);
+        // Live messages are only remembered, the backfilled batch is checked against them
+        const auto remember_delivery = [&](const Event& ev)
+        {
+            if (!config.backfill) return;
+            const auto key = message_dedupe_key(ev);
+            if (!key) return;
+            std::unique_lock lock(delivered_mutex);
+            (void)delivered.insert(*key);
+        };
+        const auto first_backfilled_delivery = [&](const Event& ev)
+        {
+            const auto key = message_dedupe_key(ev);
+            if (!key) return true;
+            std::unique_lock lock(delivered_mutex);
+            return delivered.insert(*key);
+        };
+
+        const auto dispatch = [&](Event&& ev)
+        {
+            scope.spawn(dispatch_event_async(std::move(ev), callback, exception_handler, request_close), get_scheduler());
+        };
+
+        const auto connect = [&](Lane& lane) -> ex::task<bool>
+        {
+            {
+                std::unique_lock lock(lane.mutex);
+                if (closing) co_return false;
+                lane.ws.emplace(net_client_.new_websocket_session());
+            }
+            co_await net_client_.connect_websocket_async(*lane.ws, lane.target);
+            if (config.heartbeat_interval.count() > 0)
+                lane.ws->start_heartbeat(config.heartbeat_interval, config.heartbeat_timeout,
+                    [this](const Clock::duration rtt) { ws_rtt_ = rtt.count(); });
+            co_return !closing;
+        };
+
+        const auto backfill = [&]() -> ex::task<void>
+        {
+            while (true)
+            {
+                const auto json = get_checked_response_json(co_await net_client_.http_get_async(
+                    fmt::format("/fetchMessage?sessionKey={}&count={}", sess_key_, config.backfill_batch)));
+                size_t count = 0;
+                for (const auto elem : json["data"])
+                {
+                    count++;
+                    try
+                    {
+                        Event ev = parse_event(elem);
+                        if (channel_accepts(config.channel, ev.type()) && first_backfilled_delivery(ev))
+                            dispatch(std::move(ev));
+                    }
+                    catch (...) { exception_handler(); }
                 }
+                if (count < config.backfill_batch) co_return;
+            }
+        };
+
+        const auto reconnect = [&](Lane& lane) -> ex::task<bool>
+        {
+            for (size_t attempt = 0; !closing; attempt++)
+            {
+                if (config.max_reconnect_attempts != 0 && attempt >= config.max_reconnect_attempts)
+                    throw std::runtime_error("WebSocket 重连失败次数达到上限");
+                co_await wait_async(backoff_delay(config, attempt));
+                try
+                {
+                    (void)co_await get_config_async(); // Makes sure that the session is still valid
+                    co_return co_await connect(lane);
+                }
+                catch (const MiraiException&) { throw; }
                 catch (...) { exception_handler(); }
             }
+            co_return false;
+        };
+
+        // Returns whether the connection was lost instead of being closed by us
+        const auto read_until_disconnected = [&](Lane& lane) -> ex::task<bool>
+        {
+            while (true)
+            {
+                std::optional<std::string> text;
+                try { text = co_await read_or_closed(*lane.ws); }
+                catch (...)
+                {
+                    if (!config.auto_reconnect) throw;
+                    exception_handler();
+                    co_return true;
+                }
+                if (!text) co_return !closing; // Closed by the server when we did not ask for it
+                if (recorder) recorder->write(*text); // Recorded before parsing, so that malformed frames are kept as well
+
+                try
+                {
+                    auto json = parser.parse(*text);
+                    check_json(json);
+                    Event ev = parse_event(json.value());
+                    remember_delivery(ev);
+                    dispatch(std::move(ev));
+                }
+                catch (...) { exception_handler(); }
+            }
+        };
+
+        const auto run_lane = [&](Lane& lane) -> ex::task<void>
+        {
+            if (!co_await connect(lane)) co_return;
+            while (co_await read_until_disconnected(lane) && config.auto_reconnect)
+            {
+                if (!co_await reconnect(lane)) co_return;
+                if (config.backfill) co_await backfill();
+            }
+        };
+
+        const auto work = [&]() -> ex::task<void>
+        {
+            if (lanes.size() == 1)
+                co_await run_lane(lanes[0]);
+            else // The lanes are independent, a lane ending with an error stops the other one
+                (void)co_await ex::when_all(run_lane(lanes[0]), run_lane(lanes[1]));
+        };
+
+        co_await (
+            work()
+            | ex::finally(
+                ex::sequence(scope.cleanup(), queue_.cleanup())
+                | ex::on(get_scheduler()))
+            | ex::transform_done([] { return ex::just(); })
+        );
+
+        if (stop_token.stop_requested()) co_await ex::stop();
+    }
+
+    ex::task<void> Bot::replay_events_async(const std::filesystem::path& record_path,
+        const clu::function_ref<ex::task<void>(const Event&)> callback, const ReplayConfig config,
+        const clu::function_ref<void()> exception_handler)
+    {
+        check_positive("config.max_in_flight", config.max_in_flight);
+        const auto forward = [&](Event&& ev) { return callback(ev); };
+        detail::EventLogReader log(record_path);
+
+        const auto stop_token = co_await ex::get_stop_token();
+        ex::async_scope scope;
+        std::atomic_bool closing = false;
+        const auto request_close = [&] { closing = true; };
+
+        // The replay holds the gate while reading, and waits for it when too many events are in flight,
+        // the dispatch that brings the count back under the limit releases it
+        ex::async_mutex gate;
+        std::atomic_size_t in_flight = 0;
+        const auto dispatch = [&](Event ev) -> ex::task<void>
+        {
+            co_await (
+                dispatch_event_async(std::move(ev), forward, exception_handler, request_close)
+                | ex::transform_done([] { return ex::just(); })
+            );
+            if (in_flight-- == config.max_in_flight) gate.unlock();
+        };
+
+        const auto work = [&]() -> ex::task<void>
+        {
+            co_await gate.async_lock();
+            clu::scope_exit guard([&] { gate.unlock(); });
+            std::optional<std::chrono::system_clock::time_point> first_recorded;
+            const Clock::time_point start = Clock::now();
+            while (!closing && !stop_token.stop_requested())
+            {
+                const auto record = log.next();
+                if (!record) co_return;
+                if (config.speed > 0)
+                {
+                    // Deadlines are relative to the start of the replay, so that delays do not accumulate
+                    if (!first_recorded) first_recorded = record->time;
+                    const std::chrono::duration<double> offset = record->time - *first_recorded;
+                    co_await wait_async(start + std::chrono::duration_cast<Clock::duration>(offset / config.speed));
+                }
+                bool full = false;
+                try
+                {
+                    auto json = parser.parse(record->frame.data(), record->frame.size());
+                    check_json(json);
+                    Event ev = parse_event(json.value());
+                    full = ++in_flight == config.max_in_flight;
+                    scope.spawn(dispatch(std::move(ev)), get_scheduler());
+                }
+                catch (...) { exception_handler(); }
+                if (full) co_await gate.async_lock();
+            }
         };
 
         co_await (
@@ -835,7 +1722,7 @@ namespace mpp
 
     ex::task<SessionConfig> Bot::get_config_async()
     {
-        const auto json = get_checked_response_json(co_await net_client_.http_get_async(
+        const auto json = get_checked_response_json(co_await http_get_shared_async(
             fmt::format("/config?sessionKey={}", sess_key_)));
         co_return detail::from_json<SessionConfig>(json);
     }
@@ -0,0 +1,105 @@
+#include "mirai/core/member_roster.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "../detail/json.h"
+
+namespace mpp
+{
+    void MemberRoster::build_indices()
+    {
+        const auto count = static_cast<uint32_t>(ids_.size());
+        by_id_.resize(count);
+        std::iota(by_id_.begin(), by_id_.end(), uint32_t{});
+        by_name_ = by_id_;
+        std::ranges::sort(by_id_, {}, [this](const uint32_t i) { return ids_[i].id; });
+        std::ranges::sort(by_name_, {}, [this](const uint32_t i) { return name_at(i); });
+    }
+
+    MemberRoster::MemberRoster(const std::vector<Member>& members)
+    {
+        if (members.empty()) return;
+        group_ = members.front().group;
+        size_t names_size = 0;
+        for (const auto& member : members) names_size += member.name.size();
+        ids_.reserve(members.size());
+        permissions_.reserve(members.size());
+        name_offsets_.reserve(members.size() + 1);
+        names_.reserve(names_size);
+        name_offsets_.push_back(0);
+        for (const auto& member : members)
+        {
+            ids_.push_back(member.id);
+            permissions_.push_back(member.permission);
+            names_ += member.name;
+            name_offsets_.push_back(static_cast<uint32_t>(names_.size()));
+        }
+        build_indices();
+    }
+
+    std::optional<MemberView> MemberRoster::find(const UserId id) const noexcept
+    {
+        const auto iter = std::ranges::lower_bound(by_id_, id.id, {},
+            [this](const uint32_t i) { return ids_[i].id; });
+        if (iter == by_id_.end() || ids_[*iter] != id) return std::nullopt;
+        return (*this)[*iter];
+    }
+
+    std::vector<MemberView> MemberRoster::find_by_name_prefix(const std::string_view prefix) const
+    {
+        const auto proj = [this](const uint32_t i) { return name_at(i); };
+        const auto first = std::ranges::lower_bound(by_name_, prefix, {}, proj);
+        std::vector<MemberView> result;
+        for (auto iter = first; iter != by_name_.end() && name_at(*iter).starts_with(prefix); ++iter)
+            result.push_back((*this)[*iter]);
+        return result;
+    }
+
+    Member MemberRoster::to_member(const size_t index) const
+    {
+        return
+        {
+            .group = group_,
+            .id = ids_[index],
+            .name = std::string(name_at(index)),
+            .permission = permissions_[index]
+        };
+    }
+
+    std::vector<Member> MemberRoster::to_members() const
+    {
+        std::vector<Member> result;
+        result.reserve(size());
+        for (size_t i = 0; i < size(); i++)
+            result.push_back(to_member(i));
+        return result;
+    }
+
+    MemberRoster MemberRoster::from_json(const detail::JsonElem json)
+    {
+        MemberRoster roster;
+        const simdjson::dom::array arr = json;
+        const size_t count = arr.size();
+        if (count == 0) return roster;
+        roster.ids_.reserve(count);
+        roster.permissions_.reserve(count);
+        roster.name_offsets_.reserve(count + 1);
+        roster.name_offsets_.push_back(0);
+        bool first = true;
+        for (const detail::JsonElem elem : arr)
+        {
+            if (first)
+            {
+                roster.group_ = Group::from_json(elem["group"]);
+                first = false;
+            }
+            roster.ids_.emplace_back(elem["id"].get_int64());
+            roster.permissions_.push_back(permission_from_string(elem["permission"]));
+            roster.names_ += std::string_view(elem["memberName"]);
+            roster.name_offsets_.push_back(static_cast<uint32_t>(roster.names_.size()));
+        }
+        roster.build_indices();
+        return roster;
+    }
+}
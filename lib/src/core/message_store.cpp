@@ -0,0 +1,182 @@
+#include "mirai/core/message_store.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "mirai/event/event_types.h"
+
+namespace mpp
+{
+    namespace
+    {
+        const MessageEventBase* message_event_base(const Event& ev)
+        {
+            return ev.visit(overloaded
+            {
+                [](const MessageEventBase& msg) -> const MessageEventBase* { return &msg; },
+                [](const EventBase&) -> const MessageEventBase* { return nullptr; }
+            });
+        }
+
+        UserId message_sender(const Event& ev)
+        {
+            return ev.visit(overloaded
+            {
+                [](const FriendMessageEvent& msg) { return msg.sender.id; },
+                [](const GroupMessageEvent& msg) { return msg.sender.id; },
+                [](const TempMessageEvent& msg) { return msg.sender.id; },
+                [](const EventBase&) { return UserId{}; }
+            });
+        }
+
+        // A rough estimate of the memory taken by a message, counting only the main variable-length contents
+        size_t estimate_size(const Message& msg)
+        {
+            constexpr size_t segment_overhead = 64;
+            size_t size = sizeof(Message) + msg.size() * segment_overhead;
+            for (const Segment& seg : msg)
+            {
+                // @formatter:off
+                switch (seg.type())
+                {
+                    case SegmentType::plain: size += seg.get<Plain>().text.size(); break;
+                    case SegmentType::xml:   size += seg.get<Xml>().xml.size(); break;
+                    case SegmentType::json:  size += seg.get<Json>().json.size(); break;
+                    case SegmentType::app:   size += seg.get<App>().content.size(); break;
+                    default: break;
+                }
+                // @formatter:on
+            }
+            return size;
+        }
+
+        size_t estimate_size(const SentMessage& msg)
+        {
+            size_t size = estimate_size(msg.content);
+            if (msg.quote) size += estimate_size(msg.quote->msg);
+            return size;
+        }
+    }
+
+    MessageStore::MessageStore(const size_t capacity, const size_t byte_budget):
+        slots_(std::max(capacity, size_t{ 1 })), byte_budget_(byte_budget) { index_.reserve(slots_.size()); }
+
+    void MessageStore::evict_oldest()
+    {
+        auto& slot = slots_[oldest_];
+        index_.erase(slot->id);
+        bytes_ -= slot->bytes;
+        slot.reset();
+        oldest_ = (oldest_ + 1) % slots_.size();
+        count_--;
+    }
+
+    void MessageStore::insert(const MessageId id, std::variant<Event, SentMessage>&& entry, const size_t bytes)
+    {
+        const size_t total = sizeof(Slot) + bytes;
+        if (total > byte_budget_) return;
+        if (const auto iter = index_.find(id); iter != index_.end())
+        {
+            // A message seen again is replaced in place, keeping its position in the buffer
+            auto& slot = *slots_[iter->second];
+            bytes_ = bytes_ - slot.bytes + total;
+            slot.entry = std::move(entry);
+            slot.bytes = total;
+            while (bytes_ > byte_budget_) evict_oldest();
+            return;
+        }
+        while (count_ == slots_.size() || (count_ != 0 && bytes_ + total > byte_budget_))
+            evict_oldest();
+        const size_t pos = (oldest_ + count_) % slots_.size();
+        slots_[pos].emplace(Slot{ id, std::move(entry), total });
+        bytes_ += total;
+        index_[id] = pos;
+        count_++;
+    }
+
+    size_t MessageStore::size() const
+    {
+        std::unique_lock lock(mutex_);
+        return count_;
+    }
+
+    size_t MessageStore::bytes() const
+    {
+        std::unique_lock lock(mutex_);
+        return bytes_;
+    }
+
+    void MessageStore::add(const Event& ev)
+    {
+        const MessageEventBase* base = message_event_base(ev);
+        if (!base) return;
+        const size_t bytes = estimate_size(base->msg);
+        std::unique_lock lock(mutex_);
+        insert(base->msgid(), ev, bytes);
+    }
+
+    void MessageStore::add_sent(const MessageId id, const Message& message, const std::optional<MessageId> quote)
+    {
+        using namespace std::chrono;
+        SentMessage sent
+        {
+            .source =
+            {
+                .id = id,
+                .time = static_cast<int32_t>(duration_cast<seconds>(system_clock::now().time_since_epoch()).count())
+            },
+            .content = message
+        };
+        std::unique_lock lock(mutex_);
+        if (quote)
+            if (const auto iter = index_.find(*quote); iter != index_.end())
+                if (const auto* ev = std::get_if<Event>(&slots_[iter->second]->entry))
+                {
+                    const MessageEventBase& base = *message_event_base(*ev);
+                    sent.quote = Quote{
+                        .id = *quote,
+                        .sender = message_sender(*ev),
+                        .time = base.msg.source.time,
+                        .msg = base.msg.content
+                    };
+                }
+        const size_t bytes = estimate_size(sent);
+        insert(id, std::move(sent), bytes);
+    }
+
+    std::optional<Event> MessageStore::find_event(const MessageId id) const
+    {
+        std::unique_lock lock(mutex_);
+        if (const auto iter = index_.find(id); iter != index_.end())
+            if (const auto* ev = std::get_if<Event>(&slots_[iter->second]->entry))
+                return *ev;
+        return std::nullopt;
+    }
+
+    std::optional<SentMessage> MessageStore::find_message(const MessageId id) const
+    {
+        std::unique_lock lock(mutex_);
+        const auto iter = index_.find(id);
+        if (iter == index_.end()) return std::nullopt;
+        const auto& entry = slots_[iter->second]->entry;
+        if (const auto* ev = std::get_if<Event>(&entry))
+            return message_event_base(*ev)->msg;
+        return std::get<SentMessage>(entry);
+    }
+
+    bool MessageStore::contains(const MessageId id) const
+    {
+        std::unique_lock lock(mutex_);
+        return index_.contains(id);
+    }
+
+    void MessageStore::clear()
+    {
+        std::unique_lock lock(mutex_);
+        for (auto& slot : slots_) slot.reset();
+        index_.clear();
+        bytes_ = 0;
+        oldest_ = 0;
+        count_ = 0;
+    }
+}
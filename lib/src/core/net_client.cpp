@@ -1,5 +1,13 @@
 #include "mirai/core/net_client.h"
 
+#include <atomic>
+#include <charconv>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <unordered_set>
 #ifdef __RESHARPER__ // Resharper workaround
 #   define BOOST_ASIO_HAS_CO_AWAIT 1
 #   define BOOST_ASIO_HAS_STD_COROUTINE 1
@@ -7,13 +15,19 @@
 
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/use_future.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
 #include <boost/beast/websocket.hpp>
 #include <clu/outcome.h>
+#include <clu/scope.h>
 #include <fmt/core.h>
+#include <unifex/async_scope.hpp>
+#include <unifex/inline_scheduler.hpp>
 #include <unifex/just.hpp>
 
 #include "mirai/core/exceptions.h"
@@ -36,23 +50,53 @@ namespace mpp::net
 
     namespace
     {
+        // A request body made of multiple existing buffers, which are written out with a single gather write
+        struct BufferSequenceBody
+        {
+            using value_type = std::vector<asio::const_buffer>;
+
+            static std::uint64_t size(const value_type& body) { return asio::buffer_size(body); }
+
+            class writer
+            {
+            private:
+                const value_type& body_;
+
+            public:
+                using const_buffers_type = value_type;
+
+                template <bool IsRequest, typename Fields>
+                writer(const http::header<IsRequest, Fields>&, const value_type& body): body_(body) {}
+
+                void init(error_code& ec) { ec = {}; }
+
+                boost::optional<std::pair<const_buffers_type, bool>> get(error_code& ec)
+                {
+                    ec = {};
+                    return std::pair{ body_, false };
+                }
+            };
+        };
+
         template <typename T>
         class AsioAwaiter
         {
         private:
-            asio::io_context& ctx_;
+            asio::any_io_executor exec_;
             asio::awaitable<T> awt_;
             clu::outcome<T> result_;
 
         public:
             AsioAwaiter(asio::io_context& context, asio::awaitable<T> awaitable):
-                ctx_(context), awt_(std::move(awaitable)) {}
+                exec_(context.get_executor()), awt_(std::move(awaitable)) {}
+            AsioAwaiter(asio::any_io_executor executor, asio::awaitable<T> awaitable):
+                exec_(std::move(executor)), awt_(std::move(awaitable)) {}
 
             bool await_ready() const { return false; }
 
             void await_suspend(const std::coroutine_handle<> hdl)
             {
-                co_spawn(ctx_, std::move(awt_), [&, hdl](const std::exception_ptr& eptr, T value)
+                co_spawn(exec_, std::move(awt_), [&, hdl](const std::exception_ptr& eptr, T value)
                 {
                     if (eptr)
                         result_ = eptr;
@@ -73,19 +117,21 @@ namespace mpp::net
         class AsioAwaiter<void>
         {
         private:
-            asio::io_context& ctx_;
+            asio::any_io_executor exec_;
             asio::awaitable<void> awt_;
             std::exception_ptr eptr_;
 
         public:
             AsioAwaiter(asio::io_context& context, asio::awaitable<void> awaitable):
-                ctx_(context), awt_(std::move(awaitable)) {}
+                exec_(context.get_executor()), awt_(std::move(awaitable)) {}
+            AsioAwaiter(asio::any_io_executor executor, asio::awaitable<void> awaitable):
+                exec_(std::move(executor)), awt_(std::move(awaitable)) {}
 
             bool await_ready() const { return false; }
 
             void await_suspend(const std::coroutine_handle<> hdl)
             {
-                co_spawn(ctx_, std::move(awt_), [&, hdl](const std::exception_ptr& eptr)
+                co_spawn(exec_, std::move(awt_), [&, hdl](const std::exception_ptr& eptr)
                 {
                     if (eptr) eptr_ = eptr;
                     hdl.resume();
@@ -176,6 +222,8 @@ namespace mpp::net
             {
                 if (ec_ == ws::error::closed || ec_ == sys::errc::operation_canceled)
                     return {};
+                else if (ec_ == beast::error::timeout) // No data from the peer within the idle timeout
+                    throw TimeoutException();
                 else if (ec_)
                     throw std::system_error(ec_);
 
@@ -196,6 +244,19 @@ namespace mpp::net
             if (ec && ec != beast::errc::not_connected) throw sys::system_error(ec);
         }
 
+        // Converts beast timeouts into TimeoutException, and returns whether the error is due to cancellation
+        bool is_cancellation(const sys::system_error& error)
+        {
+            if (error.code() == beast::error::timeout) throw TimeoutException();
+            return error.code() == asio::error::operation_aborted;
+        }
+
+        template <typename Stream>
+        void cancel_stream(const std::shared_ptr<Stream>& stream)
+        {
+            post(stream->get_executor(), [stream] { get_lowest_layer(*stream).cancel(); });
+        }
+
         void check_response_status(const response& res)
         {
             using enum http::status_class;
@@ -207,12 +268,15 @@ namespace mpp::net
         constexpr std::string_view json_content_type = "application/json; charset=utf-8";
     }
 
+    using parts_request = http::request<BufferSequenceBody>;
+
     class Client::Impl final
     {
     private:
         asio::io_context ctx_;
         std::string host_;
         endpoints eps_;
+        std::atomic<Duration::rep> timeout_{ Duration(std::chrono::seconds(30)).count() };
 
         static auto get_ws_stream_decorator()
         {
@@ -223,6 +287,15 @@ namespace mpp::net
             });
         }
 
+        static auto get_ws_stream_timeout(const Duration timeout)
+        {
+            ws::stream_base::timeout option{};
+            option.handshake_timeout = timeout;
+            option.idle_timeout = ws::stream_base::none();
+            option.keep_alive_pings = false;
+            return option;
+        }
+
     public:
         Impl(const std::string_view host, const std::string_view port): host_(host)
         {
@@ -232,39 +305,62 @@ namespace mpp::net
 
         asio::io_context& io_context() { return ctx_; }
         std::string_view host() const { return host_; }
+        Duration timeout() const { return Duration(timeout_.load(std::memory_order_relaxed)); }
+        void set_timeout(const Duration timeout) { timeout_.store(timeout.count(), std::memory_order_relaxed); }
 
-        std::string http_request(const request& req)
+        template <typename Body>
+        asio::awaitable<std::string> http_exchange(beast::tcp_stream& stream,
+            const http::request<Body>& req, const Duration timeout)
         {
-            beast::tcp_stream stream(ctx_);
-            stream.connect(eps_);
-            http::write(stream, req);
+            stream.expires_after(timeout);
+            co_await stream.async_connect(eps_, asio::use_awaitable);
+            co_await http::async_write(stream, req, asio::use_awaitable);
 
             beast::flat_buffer buffer;
             response res;
-            http::read(stream, buffer, res);
+            co_await http::async_read(stream, buffer, res, asio::use_awaitable);
 
             shutdown_socket(stream);
             check_response_status(res);
-            return std::move(res).body();
+            co_return std::move(res).body();
         }
 
-        ex::task<std::string> http_request_async(request req)
+        // Beast only applies the stream timeouts to asynchronous operations,
+        // so blocking requests run the asynchronous one on a private context on the calling thread
+        template <typename Body>
+        std::string http_request(const http::request<Body>& req)
         {
-            const auto impl = [&]() -> asio::awaitable<std::string>
+            asio::io_context ctx;
+            beast::tcp_stream stream(ctx);
+            auto result = co_spawn(ctx, http_exchange(stream, req, timeout()), asio::use_future);
+            ctx.run();
+            try { return result.get(); }
+            catch (const sys::system_error& error)
             {
-                beast::tcp_stream stream(ctx_);
-                co_await stream.async_connect(eps_, asio::use_awaitable);
-                co_await http::async_write(stream, req, asio::use_awaitable);
-
-                beast::flat_buffer buffer;
-                response res;
-                co_await http::async_read(stream, buffer, res, asio::use_awaitable);
+                is_cancellation(error);
+                throw;
+            }
+        }
 
-                shutdown_socket(stream);
-                check_response_status(res);
-                co_return std::move(res).body();
+        template <typename Body>
+        ex::task<std::string> http_request_async(http::request<Body> req, const Duration timeout)
+        {
+            const auto stream = std::make_shared<beast::tcp_stream>(make_strand(ctx_));
+            const auto callback = detail::make_stop_callback(
+                co_await ex::get_stop_token(), [stream] { cancel_stream(stream); });
+            const auto impl = [&]() -> asio::awaitable<std::optional<std::string>>
+            {
+                try { co_return co_await http_exchange(*stream, req, timeout); }
+                catch (const sys::system_error& error)
+                {
+                    if (!is_cancellation(error)) throw;
+                }
+                co_return std::nullopt;
             };
-            co_return co_await AsioAwaiter(ctx_, impl());
+            if (auto res = co_await AsioAwaiter(stream->get_executor(), impl()))
+                co_return std::move(*res);
+            co_await ex::stop();
+            std::terminate(); // unreachable
         }
 
         request generate_http_get_request(const std::string_view target) const
@@ -287,6 +383,20 @@ namespace mpp::net
             return req;
         }
 
+        parts_request generate_http_post_parts_request(const std::string_view target,
+            const std::string_view content_type, const std::span<const std::string_view> body) const
+        {
+            parts_request req{ http::verb::post, to_beast_sv(target), 11 };
+            req.set(http::field::host, host_);
+            req.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+            req.set(http::field::content_type, to_beast_sv(content_type));
+            req.body().reserve(body.size());
+            for (const auto part : body)
+                req.body().emplace_back(part.data(), part.size());
+            req.prepare_payload();
+            return req;
+        }
+
         auto schedule() { return ScheduleAwaiter(ctx_); }
 
         ex::task<void> wait_async(const TimePoint tp)
@@ -298,23 +408,56 @@ namespace mpp::net
             co_await ex::stop_if_requested();
         }
 
-        void connect_websocket(ws_stream& stream, const std::string_view target)
+        asio::awaitable<void> websocket_handshake(ws_stream& stream, const std::string target, const Duration timeout)
         {
-            const auto ep = get_lowest_layer(stream).connect(eps_);
+            // The websocket stream manages its own timeouts after the TCP connection is established
+            beast::tcp_stream& tcp_stream = get_lowest_layer(stream);
+            tcp_stream.expires_after(timeout);
+            const auto ep = co_await tcp_stream.async_connect(eps_, asio::use_awaitable);
+            tcp_stream.expires_never();
+            stream.set_option(get_ws_stream_timeout(timeout));
             stream.set_option(get_ws_stream_decorator());
-            stream.handshake(fmt::format("{}:{}", host_, ep.port()), std::string(target));
+            co_await stream.async_handshake(
+                fmt::format("{}:{}", host_, ep.port()), target, asio::use_awaitable);
         }
 
-        ex::task<void> connect_websocket_async(ws_stream& stream, const std::string_view target)
+        void connect_websocket(ws_stream& stream, const std::string_view target)
         {
-            const auto impl = [&]() -> asio::awaitable<void>
+            auto result = co_spawn(stream.get_executor(),
+                websocket_handshake(stream, std::string(target), timeout()), asio::use_future);
+            // The stream belongs to the shared context, which no other thread needs to be running
+            // for a blocking call, so the calling thread drives it until the handshake completes
+            if (ctx_.stopped()) ctx_.restart();
+            while (result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                ctx_.run_one_for(std::chrono::milliseconds(10));
+            try { result.get(); }
+            catch (const sys::system_error& error)
+            {
+                is_cancellation(error);
+                throw;
+            }
+        }
+
+        ex::task<void> connect_websocket_async(const std::shared_ptr<ws_stream> stream,
+            const std::string_view target, const Duration timeout)
+        {
+            const auto callback = detail::make_stop_callback(
+                co_await ex::get_stop_token(), [stream] { cancel_stream(stream); });
+            const auto impl = [&]() -> asio::awaitable<bool>
             {
-                const auto ep = co_await get_lowest_layer(stream).async_connect(eps_, asio::use_awaitable);
-                stream.set_option(get_ws_stream_decorator());
-                co_await stream.async_handshake(
-                    fmt::format("{}:{}", host_, ep.port()), std::string(target), asio::use_awaitable);
+                try
+                {
+                    co_await websocket_handshake(*stream, std::string(target), timeout);
+                    co_return true;
+                }
+                catch (const sys::system_error& error)
+                {
+                    if (!is_cancellation(error)) throw;
+                }
+                co_return false;
             };
-            co_return co_await AsioAwaiter(ctx_, impl());
+            if (!co_await AsioAwaiter(stream->get_executor(), impl()))
+                co_await ex::stop();
         }
     };
 
@@ -322,12 +465,97 @@ namespace mpp::net
     {
         friend class Client;
     private:
-        asio::io_context& ctx_;
-        ws_stream stream_;
+        // The stream lives in a shared state, which the heartbeat coroutine keeps alive
+        // until it has observed the cancellation, even if the session is destroyed first
+        struct State
+        {
+            ws_stream stream;
+            asio::steady_timer timer;
+            std::atomic<Duration::rep> rtt{ -1 };
+            std::function<void(Duration)> on_pong;
+            bool heartbeat = false;
+
+            explicit State(asio::io_context& ctx): stream(make_strand(ctx)), timer(stream.get_executor()) {}
+        };
+
+        std::shared_ptr<State> state_;
+        ws_stream& stream_;
         beast::flat_buffer buffer_;
 
+        void stop_heartbeat()
+        {
+            if (!state_->heartbeat) return;
+            // The timer is only ever touched on the strand of the stream
+            post(stream_.get_executor(), [state = state_] { state->timer.cancel(); });
+        }
+
+        static asio::awaitable<void> heartbeat_loop(const std::shared_ptr<State> state, const Duration interval)
+        {
+            try
+            {
+                while (true)
+                {
+                    state->timer.expires_after(interval);
+                    co_await state->timer.async_wait(asio::use_awaitable);
+                    if (!state->stream.is_open()) co_return;
+                    // The send time is carried in the payload, so that the pong tells the round trip time
+                    const std::string sent = fmt::format("{}", Clock::now().time_since_epoch().count());
+                    ws::ping_data payload;
+                    payload.assign(sent.data(), sent.size());
+                    co_await state->stream.async_ping(payload, asio::use_awaitable);
+                }
+            }
+            catch (const sys::system_error&) {} // Cancelled, or the connection is already broken
+        }
+
+        static void on_control_frame(State& state, const ws::frame_type kind, const beast::string_view payload)
+        {
+            if (kind != ws::frame_type::pong) return;
+            Duration::rep sent = 0;
+            if (const auto [ptr, ec] = std::from_chars(payload.data(), payload.data() + payload.size(), sent);
+                ec != std::errc{} || ptr != payload.data() + payload.size())
+                return; // Not a ping sent by us
+            const Duration rtt = Clock::now().time_since_epoch() - Duration(sent);
+            state.rtt = rtt.count();
+            if (state.on_pong) state.on_pong(rtt);
+        }
+
     public:
-        explicit Impl(asio::io_context& ctx): ctx_(ctx), stream_(make_strand(ctx)) {}
+        explicit Impl(asio::io_context& ctx): state_(std::make_shared<State>(ctx)), stream_(state_->stream) {}
+        ~Impl() noexcept { stop_heartbeat(); }
+        Impl(const Impl&) = delete;
+        Impl& operator=(const Impl&) = delete;
+
+        void start_heartbeat(const Duration interval, const Duration timeout, std::function<void(Duration)> on_pong)
+        {
+            if (timeout <= interval)
+                throw std::invalid_argument("心跳超时时长必须大于发送 ping 的间隔");
+            if (std::exchange(state_->heartbeat, true))
+                throw std::logic_error("心跳已经启动");
+            state_->on_pong = std::move(on_pong);
+            post(stream_.get_executor(), [state = state_, interval, timeout]
+            {
+                // The connection is considered dead when nothing, not even a pong, arrives within the timeout
+                ws::stream_base::timeout option{};
+                option.handshake_timeout = timeout;
+                option.idle_timeout = timeout;
+                option.keep_alive_pings = false;
+                state->stream.set_option(option);
+                // The callback is owned by the stream, so it cannot outlive the state
+                state->stream.control_callback(
+                    [raw = state.get()](const ws::frame_type kind, const beast::string_view payload)
+                    {
+                        on_control_frame(*raw, kind, payload);
+                    });
+                co_spawn(state->stream.get_executor(), heartbeat_loop(state, interval), asio::detached);
+            });
+        }
+
+        std::optional<Duration> rtt() const noexcept
+        {
+            if (const auto rtt = state_->rtt.load(); rtt >= 0) return Duration(rtt);
+            return std::nullopt;
+        }
 
         std::string read()
         {
@@ -347,18 +575,150 @@ namespace mpp::net
             std::terminate(); // unreachable
         }
 
-        void close() { stream_.close(ws::normal); }
+        void close()
+        {
+            stop_heartbeat();
+            stream_.close(ws::normal);
+        }
 
         ex::task<void> close_async()
         {
+            stop_heartbeat();
             const auto impl = [&]() -> asio::awaitable<void>
             {
                 co_await stream_.async_close(ws::normal, asio::use_awaitable);
             };
-            co_await AsioAwaiter(ctx_, impl());
+            co_await AsioAwaiter(stream_.get_executor(), impl());
         }
     };
 
+    class WebhookServer::Impl final
+    {
+    private:
+        // Shared with the connections, so that the handler is never called after serving ends
+        struct State
+        {
+            std::shared_mutex mutex;
+            Handler handler;
+            std::mutex connections_mutex;
+            std::unordered_set<std::shared_ptr<beast::tcp_stream>> connections; // Closed when serving ends
+
+            void close_connections()
+            {
+                // Closing rather than cancelling, so that a connection busy with a request does not read another one
+                std::unique_lock lock(connections_mutex);
+                for (const auto& stream : connections)
+                    post(stream->get_executor(), [stream] { stream->close(); });
+            }
+        };
+
+        asio::io_context& ctx_;
+        std::shared_ptr<tcp::acceptor> acceptor_; // Shared with a pending close
+
+        static asio::awaitable<void> serve_connection(
+            const std::shared_ptr<beast::tcp_stream> stream_ptr, const std::shared_ptr<State> state)
+        {
+            beast::tcp_stream& stream = *stream_ptr;
+            const clu::scope_exit unregister([&]
+            {
+                std::unique_lock lock(state->connections_mutex);
+                state->connections.erase(stream_ptr);
+            });
+            try
+            {
+                beast::flat_buffer buffer;
+                while (true)
+                {
+                    stream.expires_after(std::chrono::seconds(60)); // Idle keep-alive connections are closed
+                    http::request<http::string_body> req;
+                    co_await http::async_read(stream, buffer, req, asio::use_awaitable);
+
+                    response res{ http::status::ok, req.version() };
+                    res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+                    res.keep_alive(req.keep_alive());
+                    if (req.method() != http::verb::post)
+                        res.result(http::status::method_not_allowed);
+                    else
+                    {
+                        std::shared_lock lock(state->mutex);
+                        if (!state->handler)
+                            res.result(http::status::service_unavailable);
+                        else
+                        {
+                            try { state->handler(std::move(req.body())); }
+                            catch (...) { res.result(http::status::bad_request); }
+                        }
+                    }
+                    res.set(http::field::content_type, to_beast_sv(json_content_type));
+                    res.body() = "{}";
+                    res.prepare_payload();
+                    co_await http::async_write(stream, res, asio::use_awaitable);
+                    if (!res.keep_alive()) break;
+                }
+                shutdown_socket(stream);
+            }
+            catch (const sys::system_error&) {} // Closed by the peer, timed out or closed when serving ends
+        }
+
+        static ex::task<void> serve_connection_async(
+            const std::shared_ptr<beast::tcp_stream> stream, const std::shared_ptr<State> state)
+        {
+            co_await AsioAwaiter(stream->get_executor(), serve_connection(stream, state));
+        }
+
+    public:
+        Impl(asio::io_context& ctx, const std::string_view address, const uint16_t port):
+            ctx_(ctx), acceptor_(std::make_shared<tcp::acceptor>(
+                make_strand(ctx), tcp::endpoint(asio::ip::make_address(address), port))) {}
+
+        uint16_t port() const { return acceptor_->local_endpoint().port(); }
+
+        ex::task<void> serve_async(Handler handler)
+        {
+            const auto state = std::make_shared<State>();
+            state->handler = std::move(handler);
+            const clu::scope_exit deactivate([&]
+            {
+                std::unique_lock lock(state->mutex);
+                state->handler = nullptr;
+            });
+
+            ex::async_scope scope; // The connections, joined before serving ends
+            const auto callback = detail::make_stop_callback(co_await ex::get_stop_token(), [&] { close(); });
+            const auto impl = [&]() -> asio::awaitable<void>
+            {
+                try
+                {
+                    while (true)
+                    {
+                        tcp::socket socket = co_await acceptor_->async_accept(make_strand(ctx_), asio::use_awaitable);
+                        const auto stream = std::make_shared<beast::tcp_stream>(std::move(socket));
+                        {
+                            std::unique_lock lock(state->connections_mutex);
+                            state->connections.insert(stream);
+                        }
+                        scope.spawn(serve_connection_async(stream, state), ex::inline_scheduler{});
+                    }
+                }
+                catch (const sys::system_error& error)
+                {
+                    if (error.code() != asio::error::operation_aborted) throw;
+                }
+            };
+            std::exception_ptr eptr;
+            try { co_await AsioAwaiter(acceptor_->get_executor(), impl()); }
+            catch (...) { eptr = std::current_exception(); }
+
+            // No connection outlives serving, idle keep-alive ones are cut off instead of waited for
+            state->close_connections();
+            co_await scope.cleanup();
+            if (eptr) std::rethrow_exception(eptr);
+            co_await ex::stop_if_requested();
+        }
+
+        void close() { post(acceptor_->get_executor(), [acceptor = acceptor_] { acceptor->close(); }); }
+    };
+
     Client::Client(const std::string_view host, const std::string_view port): impl_(std::make_unique<Impl>(host, port)) {}
     Client::~Client() noexcept = default;
     Client::Client(Client&&) noexcept = default;
@@ -368,6 +728,8 @@ namespace mpp::net
     void Client::run() { io_context().run(); }
     asio::io_context& Client::io_context() noexcept { return impl_->io_context(); }
     std::string_view Client::host() const noexcept { return impl_->host(); }
+    Duration Client::timeout() const noexcept { return impl_->timeout(); }
+    void Client::set_timeout(const Duration timeout) noexcept { impl_->set_timeout(timeout); }
 
     std::string Client::http_get(const std::string_view target)
     {
@@ -376,9 +738,14 @@ namespace mpp::net
     }
 
     ex::task<std::string> Client::http_get_async(const std::string_view target)
+    {
+        return http_get_async(target, impl_->timeout());
+    }
+
+    ex::task<std::string> Client::http_get_async(const std::string_view target, const Duration timeout)
     {
         return impl_->http_request_async(
-            impl_->generate_http_get_request(target));
+            impl_->generate_http_get_request(target), timeout);
     }
 
     std::string Client::http_post(const std::string_view target,
@@ -390,9 +757,29 @@ namespace mpp::net
 
     ex::task<std::string> Client::http_post_async(const std::string_view target,
         const std::string_view content_type, std::string body)
+    {
+        return http_post_async(target, content_type, std::move(body), impl_->timeout());
+    }
+
+    ex::task<std::string> Client::http_post_async(const std::string_view target,
+        const std::string_view content_type, std::string body, const Duration timeout)
     {
         return impl_->http_request_async(
-            impl_->generate_http_post_request(target, content_type, std::move(body)));
+            impl_->generate_http_post_request(target, content_type, std::move(body)), timeout);
+    }
+
+    std::string Client::http_post_parts(const std::string_view target,
+        const std::string_view content_type, const std::span<const std::string_view> body)
+    {
+        return impl_->http_request(
+            impl_->generate_http_post_parts_request(target, content_type, body));
+    }
+
+    ex::task<std::string> Client::http_post_parts_async(const std::string_view target,
+        const std::string_view content_type, const std::span<const std::string_view> body)
+    {
+        return impl_->http_request_async(
+            impl_->generate_http_post_parts_request(target, content_type, body), impl_->timeout());
     }
 
     std::string Client::http_post_json(const std::string_view target, std::string body)
@@ -402,9 +789,15 @@ namespace mpp::net
     }
 
     ex::task<std::string> Client::http_post_json_async(const std::string_view target, std::string body)
+    {
+        return http_post_json_async(target, std::move(body), impl_->timeout());
+    }
+
+    ex::task<std::string> Client::http_post_json_async(const std::string_view target,
+        std::string body, const Duration timeout)
     {
         return impl_->http_request_async(
-            impl_->generate_http_post_request(target, json_content_type, std::move(body)));
+            impl_->generate_http_post_request(target, json_content_type, std::move(body)), timeout);
     }
 
     ex::task<void> Client::schedule() { co_await impl_->schedule(); }
@@ -421,8 +814,21 @@ namespace mpp::net
 
     ex::task<void> Client::connect_websocket_async(WebsocketSession& ws, const std::string_view target)
     {
+        return connect_websocket_async(ws, target, impl_->timeout());
+    }
+
+    ex::task<void> Client::connect_websocket_async(WebsocketSession& ws,
+        const std::string_view target, const Duration timeout)
+    {
+        // The stream is shared with the session, so a late cancellation never outlives it
+        const auto& state = ws.pimpl_ptr()->state_;
         return impl_->connect_websocket_async(
-            ws.pimpl_ptr()->stream_, target);
+            std::shared_ptr<ws_stream>(state, &state->stream), target, timeout);
+    }
+
+    WebhookServer Client::new_webhook_server(const std::string_view address, const uint16_t port)
+    {
+        return WebhookServer(io_context(), address, port);
     }
 
     WebsocketSession::WebsocketSession(asio::io_context& ctx): impl_(std::make_unique<Impl>(ctx)) {}
@@ -432,7 +838,23 @@ namespace mpp::net
 
     std::string WebsocketSession::read() { return impl_->read(); }
     ex::task<std::string> WebsocketSession::read_async() { return impl_->read_async(); }
+    void WebsocketSession::start_heartbeat(const Duration interval, const Duration timeout,
+        std::function<void(Duration)> on_pong)
+    {
+        impl_->start_heartbeat(interval, timeout, std::move(on_pong));
+    }
+    std::optional<Duration> WebsocketSession::rtt() const noexcept { return impl_->rtt(); }
     void WebsocketSession::close() { return impl_->close(); }
     ex::task<void> WebsocketSession::close_async() { return impl_->close_async(); }
+
+    WebhookServer::WebhookServer(asio::io_context& ctx, const std::string_view address, const uint16_t port):
+        impl_(std::make_unique<Impl>(ctx, address, port)) {}
+    WebhookServer::~WebhookServer() noexcept = default;
+    WebhookServer::WebhookServer(WebhookServer&&) noexcept = default;
+    WebhookServer& WebhookServer::operator=(WebhookServer&&) noexcept = default;
+
+    uint16_t WebhookServer::port() const noexcept { return impl_->port(); }
+    ex::task<void> WebhookServer::serve_async(Handler handler) { return impl_->serve_async(std::move(handler)); }
+    void WebhookServer::close() { impl_->close(); }
     // ReSharper restore CppMemberFunctionMayBeConst
 }
@@ -0,0 +1,294 @@
+#include "mirai/core/roster_cache.h"
+
+#include "mirai/event/event_types.h"
+
+namespace mpp
+{
+    namespace
+    {
+        bool affects_roster(const EventType type)
+        {
+            // @formatter:off
+            switch (type)
+            {
+                case EventType::friend_message: case EventType::group_message:
+                case EventType::bot_group_permission_change: case EventType::bot_join_group:
+                case EventType::bot_quit: case EventType::bot_kicked: case EventType::group_name_change:
+                case EventType::member_join: case EventType::member_quit: case EventType::member_kicked:
+                case EventType::member_card_change: case EventType::member_special_title_change:
+                case EventType::member_permission_change:
+                    return true;
+                default: return false;
+            }
+            // @formatter:on
+        }
+    }
+
+    bool RosterCache::is_fresh(const std::optional<TimePoint> fetched) const noexcept
+    {
+        return fetched && Clock::now() - *fetched < max_age_;
+    }
+
+    const RosterCache::GroupEntry* RosterCache::find_fresh_members(const GroupId group) const
+    {
+        if (const auto iter = groups_.find(group);
+            iter != groups_.end() && is_fresh(iter->second.members_fetched))
+            return &iter->second;
+        return nullptr;
+    }
+
+    void RosterCache::update_member(const Member& member)
+    {
+        if (const auto iter = groups_.find(member.group.id);
+            iter != groups_.end() && iter->second.members_fetched)
+            iter->second.members.insert_or_assign(member.id, member);
+    }
+
+    void RosterCache::remove_member(const Member& member)
+    {
+        if (const auto iter = groups_.find(member.group.id); iter != groups_.end())
+        {
+            iter->second.members.erase(member.id);
+            iter->second.member_infos.erase(member.id);
+        }
+    }
+
+    void RosterCache::replay_since(const uint64_t seq)
+    {
+        for (const auto& [ev_seq, ev] : journal_)
+            if (ev_seq >= seq) apply(ev);
+    }
+
+    void RosterCache::end_fetch() noexcept
+    {
+        const std::scoped_lock lock(mutex_);
+        if (--active_fetches_ == 0) journal_.clear();
+    }
+
+    std::optional<std::vector<Friend>> RosterCache::friends() const
+    {
+        const std::scoped_lock lock(mutex_);
+        if (!is_fresh(friends_fetched_)) return std::nullopt;
+        std::vector<Friend> result;
+        result.reserve(friends_.size());
+        for (const auto& [id, fr] : friends_)
+            result.push_back(fr);
+        return result;
+    }
+
+    std::optional<std::vector<Group>> RosterCache::groups() const
+    {
+        const std::scoped_lock lock(mutex_);
+        if (!is_fresh(groups_fetched_)) return std::nullopt;
+        std::vector<Group> result;
+        result.reserve(groups_.size());
+        for (const auto& [id, entry] : groups_)
+            result.push_back(entry.group);
+        return result;
+    }
+
+    std::optional<std::vector<Member>> RosterCache::members(const GroupId group) const
+    {
+        const std::scoped_lock lock(mutex_);
+        const GroupEntry* entry = find_fresh_members(group);
+        if (!entry) return std::nullopt;
+        std::vector<Member> result;
+        result.reserve(entry->members.size());
+        for (const auto& [id, member] : entry->members)
+            result.push_back(member);
+        return result;
+    }
+
+    std::optional<Friend> RosterCache::find_friend(const UserId id) const
+    {
+        const std::scoped_lock lock(mutex_);
+        if (!is_fresh(friends_fetched_)) return std::nullopt;
+        if (const auto iter = friends_.find(id); iter != friends_.end())
+            return iter->second;
+        return std::nullopt;
+    }
+
+    std::optional<Group> RosterCache::find_group(const GroupId id) const
+    {
+        const std::scoped_lock lock(mutex_);
+        if (!is_fresh(groups_fetched_)) return std::nullopt;
+        if (const auto iter = groups_.find(id); iter != groups_.end())
+            return iter->second.group;
+        return std::nullopt;
+    }
+
+    std::optional<Member> RosterCache::find_member(const GroupId group, const UserId user) const
+    {
+        const std::scoped_lock lock(mutex_);
+        if (const GroupEntry* entry = find_fresh_members(group))
+            if (const auto iter = entry->members.find(user); iter != entry->members.end())
+                return iter->second;
+        return std::nullopt;
+    }
+
+    std::optional<MemberInfo> RosterCache::find_member_info(const GroupId group, const UserId user) const
+    {
+        const std::scoped_lock lock(mutex_);
+        if (const auto group_iter = groups_.find(group); group_iter != groups_.end())
+        {
+            const auto& infos = group_iter->second.member_infos;
+            if (const auto iter = infos.find(user);
+                iter != infos.end() && is_fresh(iter->second.fetched))
+                return iter->second.info;
+        }
+        return std::nullopt;
+    }
+
+    void RosterCache::set_friends(const std::vector<Friend>& friends, const Fetch& fetch)
+    {
+        const std::scoped_lock lock(mutex_);
+        friends_.clear();
+        for (const Friend& fr : friends)
+            friends_.emplace(fr.id, fr);
+        friends_fetched_ = Clock::now();
+        replay_since(fetch.seq_);
+    }
+
+    void RosterCache::set_groups(const std::vector<Group>& groups, const Fetch& fetch)
+    {
+        const std::scoped_lock lock(mutex_);
+        std::unordered_map<GroupId, GroupEntry> entries;
+        for (const Group& group : groups)
+        {
+            GroupEntry& entry = entries[group.id];
+            if (const auto iter = groups_.find(group.id); iter != groups_.end())
+                entry = std::move(iter->second); // Keep the cached members of the groups still present
+            entry.group = group;
+        }
+        groups_ = std::move(entries);
+        groups_fetched_ = Clock::now();
+        replay_since(fetch.seq_);
+    }
+
+    void RosterCache::set_members(const GroupId group, const std::vector<Member>& members, const Fetch& fetch)
+    {
+        const std::scoped_lock lock(mutex_);
+        GroupEntry& entry = groups_[group];
+        if (!entry.group.id) entry.group = members.empty() ? Group{ .id = group } : members.front().group;
+        entry.members.clear();
+        for (const Member& member : members)
+            entry.members.emplace(member.id, member);
+        entry.members_fetched = Clock::now();
+        replay_since(fetch.seq_);
+    }
+
+    void RosterCache::set_member_info(const GroupId group, const UserId user, const MemberInfo& info, const Fetch& fetch)
+    {
+        const std::scoped_lock lock(mutex_);
+        GroupEntry& entry = groups_[group];
+        if (!entry.group.id) entry.group.id = group;
+        entry.member_infos.insert_or_assign(user, CachedMemberInfo{ info, Clock::now() });
+        replay_since(fetch.seq_);
+    }
+
+    RosterCache::Fetch RosterCache::begin_fetch()
+    {
+        const std::scoped_lock lock(mutex_);
+        active_fetches_++;
+        return Fetch(this, next_seq_);
+    }
+
+    void RosterCache::update(const Event& ev)
+    {
+        if (!affects_roster(ev.type())) return;
+        const std::scoped_lock lock(mutex_);
+        apply(ev);
+        // Every update only sets the new state, so replaying one that the fetched list already reflects is harmless
+        if (active_fetches_ != 0) journal_.emplace_back(next_seq_++, ev);
+    }
+
+    void RosterCache::apply(const Event& ev)
+    {
+        switch (ev.type())
+        {
+            case EventType::friend_message:
+            {
+                if (!friends_fetched_) return;
+                const Friend& sender = ev.get<FriendMessageEvent>().sender;
+                friends_.insert_or_assign(sender.id, sender);
+                return;
+            }
+            case EventType::group_message: return update_member(ev.get<GroupMessageEvent>().sender);
+            case EventType::bot_group_permission_change:
+            {
+                const auto& e = ev.get<BotGroupPermissionChangeEvent>();
+                if (const auto iter = groups_.find(e.group.id); iter != groups_.end())
+                    iter->second.group.permission = e.current;
+                return;
+            }
+            case EventType::bot_join_group:
+            {
+                if (!groups_fetched_) return;
+                const Group& group = ev.get<BotJoinGroupEvent>().group;
+                groups_.insert_or_assign(group.id, GroupEntry{ .group = group });
+                return;
+            }
+            case EventType::bot_quit: groups_.erase(ev.get<BotQuitEvent>().group.id); return;
+            case EventType::bot_kicked: groups_.erase(ev.get<BotKickedEvent>().group.id); return;
+            case EventType::group_name_change:
+            {
+                const auto& e = ev.get<GroupNameChangeEvent>();
+                if (const auto iter = groups_.find(e.group.id); iter != groups_.end())
+                {
+                    iter->second.group.name = e.current;
+                    for (auto& [id, member] : iter->second.members)
+                        member.group.name = e.current;
+                }
+                return;
+            }
+            case EventType::member_join: return update_member(ev.get<MemberJoinEvent>().member);
+            case EventType::member_quit: return remove_member(ev.get<MemberQuitEvent>().member);
+            case EventType::member_kicked: return remove_member(ev.get<MemberKickedEvent>().member);
+            case EventType::member_card_change:
+            {
+                const auto& e = ev.get<MemberCardChangeEvent>();
+                if (const auto iter = groups_.find(e.member.group.id); iter != groups_.end())
+                {
+                    GroupEntry& entry = iter->second;
+                    if (const auto member = entry.members.find(e.member.id); member != entry.members.end())
+                        member->second.name = e.current;
+                    if (const auto info = entry.member_infos.find(e.member.id); info != entry.member_infos.end())
+                        info->second.info.name = e.current;
+                }
+                return;
+            }
+            case EventType::member_special_title_change:
+            {
+                const auto& e = ev.get<MemberSpecialTitleChangeEvent>();
+                if (const auto iter = groups_.find(e.member.group.id); iter != groups_.end())
+                {
+                    auto& infos = iter->second.member_infos;
+                    if (const auto info = infos.find(e.member.id); info != infos.end())
+                        info->second.info.special_title = e.current;
+                }
+                return;
+            }
+            case EventType::member_permission_change:
+            {
+                const auto& e = ev.get<MemberPermissionChangeEvent>();
+                if (const auto iter = groups_.find(e.member.group.id); iter != groups_.end())
+                {
+                    auto& members = iter->second.members;
+                    if (const auto member = members.find(e.member.id); member != members.end())
+                        member->second.permission = e.current;
+                }
+                return;
+            }
+            default: return;
+        }
+    }
+
+    void RosterCache::invalidate()
+    {
+        const std::scoped_lock lock(mutex_);
+        friends_.clear();
+        friends_fetched_.reset();
+        groups_.clear();
+        groups_fetched_.reset();
+    }
+}
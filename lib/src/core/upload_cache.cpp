@@ -0,0 +1,149 @@
+#include "mirai/core/upload_cache.h"
+
+#include <charconv>
+#include <iterator>
+#include <sstream>
+#include <fmt/format.h>
+
+#include "../detail/sha256.h"
+#include "../detail/stable_hash.h"
+
+namespace mpp
+{
+    namespace
+    {
+        std::string format_digest(const detail::Sha256Digest& digest)
+        {
+            std::string hex;
+            hex.reserve(digest.size() * 2);
+            for (const uint8_t byte : digest) fmt::format_to(std::back_inserter(hex), "{:02x}", byte);
+            return hex;
+        }
+
+        bool parse_digest(const std::string_view hex, detail::Sha256Digest& digest)
+        {
+            if (hex.size() != digest.size() * 2) return false;
+            for (size_t i = 0; i < digest.size(); i++)
+            {
+                const auto [ptr, ec] = std::from_chars(hex.data() + 2 * i, hex.data() + 2 * i + 2, digest[i], 16);
+                if (ec != std::errc{} || ptr != hex.data() + 2 * i + 2) return false;
+            }
+            return true;
+        }
+    }
+
+    size_t UploadCache::KeyHash::operator()(const Key& key) const noexcept
+    {
+        size_t hash = static_cast<size_t>(key.hash);
+        clu::hash_combine(hash, static_cast<size_t>(key.size));
+        clu::hash_combine(hash, static_cast<size_t>(key.type));
+        clu::hash_combine(hash, static_cast<size_t>(key.kind));
+        return hash;
+    }
+
+    UploadCache::Key UploadCache::make_key(const Kind kind, const TargetType type, const std::string_view content) noexcept
+    {
+        return { .hash = content_hash(content), .size = content.size(), .type = type, .kind = kind };
+    }
+
+    uint64_t UploadCache::content_hash(const std::string_view content) noexcept
+    {
+        detail::StableHasher hasher;
+        hasher.update_raw(content);
+        return hasher.value();
+    }
+
+    UploadCache::UploadCache(const std::filesystem::path& index_path)
+    {
+        load_index(index_path);
+        index_.open(index_path, std::ios::out | std::ios::app);
+        if (index_.fail()) throw std::runtime_error("无法打开上传缓存索引文件");
+    }
+
+    // Each line of the index file is an entry: kind, target type, hash, file size, SHA-256 digest in hex, id and url,
+    // where a missing url is written as -. Lines without a digest cannot be verified and are skipped
+    void UploadCache::load_index(const std::filesystem::path& index_path)
+    {
+        std::ifstream fs(index_path);
+        if (fs.fail()) return;
+        std::string line;
+        while (std::getline(fs, line))
+        {
+            std::istringstream iss(line);
+            int kind = 0, type = 0;
+            Key key;
+            Entry entry;
+            std::string digest, url;
+            if (!(iss >> kind >> type >> std::hex >> key.hash >> std::dec >> key.size >> digest >> entry.id >> url)) continue;
+            if (kind > static_cast<int>(Kind::voice) || type > static_cast<int>(TargetType::temp)) continue;
+            if (!parse_digest(digest, entry.digest)) continue;
+            key.kind = static_cast<Kind>(kind);
+            key.type = static_cast<TargetType>(type);
+            if (url != "-") entry.url = std::move(url);
+            entries_.insert_or_assign(key, std::move(entry));
+        }
+    }
+
+    std::optional<UploadCache::Entry> UploadCache::find(const Key& key, const std::string_view content) const
+    {
+        std::optional<Entry> entry;
+        {
+            std::unique_lock lock(mutex_);
+            if (const auto iter = entries_.find(key); iter != entries_.end())
+                entry = iter->second;
+        }
+        if (entry && entry->digest != detail::sha256(content)) return std::nullopt; // Collision of the key hash
+        return entry;
+    }
+
+    void UploadCache::add(const Key& key, Entry entry)
+    {
+        std::unique_lock lock(mutex_);
+        if (index_.is_open())
+        {
+            index_ << fmt::format("{} {} {:x} {} {} {} {}\n",
+                static_cast<int>(key.kind), static_cast<int>(key.type), key.hash, key.size,
+                format_digest(entry.digest), entry.id, entry.url ? std::string_view(*entry.url) : "-");
+            index_.flush();
+        }
+        entries_.insert_or_assign(key, std::move(entry));
+    }
+
+    std::optional<Image> UploadCache::find_image(const TargetType type, const std::string_view content) const
+    {
+        auto entry = find(make_key(Kind::image, type, content), content);
+        if (!entry) return std::nullopt;
+        return Image{ .image_id = std::move(entry->id), .url = std::move(entry->url) };
+    }
+
+    std::optional<Voice> UploadCache::find_voice(const TargetType type, const std::string_view content) const
+    {
+        auto entry = find(make_key(Kind::voice, type, content), content);
+        if (!entry) return std::nullopt;
+        return Voice{ .voice_id = std::move(entry->id), .url = std::move(entry->url) };
+    }
+
+    void UploadCache::add_image(const TargetType type, const std::string_view content, const Image& image)
+    {
+        if (!image.image_id) return;
+        add(make_key(Kind::image, type, content), { detail::sha256(content), *image.image_id, image.url });
+    }
+
+    void UploadCache::add_voice(const TargetType type, const std::string_view content, const Voice& voice)
+    {
+        if (!voice.voice_id) return;
+        add(make_key(Kind::voice, type, content), { detail::sha256(content), *voice.voice_id, voice.url });
+    }
+
+    size_t UploadCache::size() const
+    {
+        std::unique_lock lock(mutex_);
+        return entries_.size();
+    }
+
+    void UploadCache::clear()
+    {
+        std::unique_lock lock(mutex_);
+        entries_.clear();
+    }
+}
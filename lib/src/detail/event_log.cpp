@@ -0,0 +1,68 @@
+#include "event_log.h"
+
+#include <charconv>
+#include <stdexcept>
+#include <fmt/format.h>
+
+namespace mpp::detail
+{
+    namespace
+    {
+        void truncate_torn_tail(const std::filesystem::path& path)
+        {
+            std::error_code ec;
+            const auto size = std::filesystem::file_size(path, ec);
+            if (ec || size == 0) return;
+            size_t complete = 0;
+            {
+                EventLogReader reader(path);
+                try { while (reader.next()) {} }
+                catch (const std::runtime_error&) {} // Keep the records before a malformed one
+                complete = reader.position();
+            }
+            if (complete < size) std::filesystem::resize_file(path, complete);
+        }
+    }
+
+    EventLogWriter::EventLogWriter(const std::filesystem::path& path)
+    {
+        truncate_torn_tail(path);
+        file_.open(path, std::ios::out | std::ios::app | std::ios::binary);
+        if (file_.fail()) throw std::runtime_error("failed to open event log");
+    }
+
+    void EventLogWriter::write(const std::string_view frame)
+    {
+        using namespace std::chrono;
+        // The time is taken under the lock, so that records written from different threads stay in time order
+        std::unique_lock lock(mutex_);
+        const auto time = duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+        file_ << fmt::format("{} {}\n", time, frame.size()) << frame << '\n';
+        file_.flush(); // Keeps the log usable if the process does not exit cleanly
+    }
+
+    std::optional<EventLogRecord> EventLogReader::next()
+    {
+        using namespace std::chrono;
+        const std::string_view data = file_.view();
+        const size_t line_end = data.find('\n', pos_);
+        if (line_end == std::string_view::npos) return std::nullopt;
+
+        const char* const first = data.data() + pos_;
+        const char* const last = data.data() + line_end;
+        int64_t time = 0;
+        size_t size = 0;
+        std::from_chars_result res = std::from_chars(first, last, time);
+        if (res.ec == std::errc{} && res.ptr != last && *res.ptr == ' ')
+            res = std::from_chars(res.ptr + 1, last, size);
+        if (res.ec != std::errc{} || res.ptr != last) throw std::runtime_error("malformed event log record");
+
+        const size_t frame_begin = line_end + 1;
+        if (data.size() - frame_begin < size + 1) return std::nullopt;
+        pos_ = frame_begin + size + 1;
+        return EventLogRecord{
+            .time = system_clock::time_point(duration_cast<system_clock::duration>(microseconds(time))),
+            .frame = data.substr(frame_begin, size)
+        };
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string_view>
+
+#include "mapped_file.h"
+
+namespace mpp::detail
+{
+    // Each record of an event log is a header line holding the receive time in microseconds
+    // since the Unix epoch and the size of the frame in bytes, followed by the raw frame and a newline.
+    // The explicit size keeps the frames intact regardless of their content.
+
+    // Appends frames to an event log, can be used from multiple threads.
+    // A record torn by a crash at the end of an existing log is cut off on open, so that new records stay aligned
+    class EventLogWriter final
+    {
+    private:
+        std::mutex mutex_;
+        std::ofstream file_;
+
+    public:
+        explicit EventLogWriter(const std::filesystem::path& path);
+        void write(std::string_view frame); // Stamps the frame with the current time, records are in time order
+    };
+
+    struct EventLogRecord
+    {
+        std::chrono::system_clock::time_point time;
+        std::string_view frame; // Refers to the mapped file of the reader
+    };
+
+    class EventLogReader final
+    {
+    private:
+        MappedFile file_;
+        size_t pos_ = 0;
+
+    public:
+        explicit EventLogReader(const std::filesystem::path& path): file_(path) {}
+        // Returns empty at the end of the log, a record cut short by a crash while recording also ends the log
+        std::optional<EventLogRecord> next();
+        size_t position() const noexcept { return pos_; } // Offset of the end of the last record read
+    };
+}
@@ -0,0 +1,105 @@
+#include "mapped_file.h"
+
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#   ifndef WIN32_LEAN_AND_MEAN
+#       define WIN32_LEAN_AND_MEAN
+#   endif
+#   ifndef NOMINMAX
+#       define NOMINMAX
+#   endif
+#   include <Windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+namespace mpp::detail
+{
+#ifdef _WIN32
+    MappedFile::MappedFile(const std::filesystem::path& path)
+    {
+        const HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("failed to open binary file");
+
+        LARGE_INTEGER size{};
+        if (!GetFileSizeEx(file, &size))
+        {
+            CloseHandle(file);
+            throw std::runtime_error("failed to read binary file");
+        }
+        if (size.QuadPart == 0) // Empty files cannot be mapped
+        {
+            CloseHandle(file);
+            return;
+        }
+
+        const HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (!mapping) throw std::runtime_error("failed to read binary file");
+        const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping); // The view keeps the mapping alive
+        if (!view) throw std::runtime_error("failed to read binary file");
+
+        data_ = static_cast<const char*>(view);
+        size_ = static_cast<size_t>(size.QuadPart);
+    }
+
+    void MappedFile::unmap() noexcept
+    {
+        if (data_) UnmapViewOfFile(data_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+#else
+    MappedFile::MappedFile(const std::filesystem::path& path)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1) throw std::runtime_error("failed to open binary file");
+
+        struct stat st{};
+        if (::fstat(fd, &st) == -1)
+        {
+            ::close(fd);
+            throw std::runtime_error("failed to read binary file");
+        }
+        if (st.st_size == 0) // Empty files cannot be mapped
+        {
+            ::close(fd);
+            return;
+        }
+
+        void* addr = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // The mapping keeps the file alive
+        if (addr == MAP_FAILED) throw std::runtime_error("failed to read binary file");
+        ::madvise(addr, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+
+        data_ = static_cast<const char*>(addr);
+        size_ = static_cast<size_t>(st.st_size);
+    }
+
+    void MappedFile::unmap() noexcept
+    {
+        if (data_) ::munmap(const_cast<char*>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+#endif
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept:
+        data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (&other == this) return *this;
+        unmap();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        return *this;
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+
+namespace mpp::detail
+{
+    // Read-only memory mapping of a whole file, the contents are paged in lazily from the page cache
+    class MappedFile final
+    {
+    private:
+        const char* data_ = nullptr;
+        size_t size_ = 0;
+
+        void unmap() noexcept;
+
+    public:
+        MappedFile() = default;
+        explicit MappedFile(const std::filesystem::path& path);
+        ~MappedFile() noexcept { unmap(); }
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        const char* data() const noexcept { return data_; }
+        size_t size() const noexcept { return size_; }
+        std::string_view view() const noexcept { return { data_, size_ }; }
+    };
+}
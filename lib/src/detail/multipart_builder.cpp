@@ -1,11 +1,29 @@
 #include "multipart_builder.h"
 
 #include <fmt/core.h>
-#include <fstream>
 #include <clu/take.h>
 
+#include "mapped_file.h"
+
 namespace mpp::detail
 {
+    void MultipartBuilder::add_file_header(const std::string_view key, const std::string_view filename)
+    {
+        str_ += fmt::format("\r\n"
+            "--{}\r\n"
+            "Content-Disposition: form-data; name=\"{}\"; filename=\"{}\"\r\n"
+            "Content-Type: application/octet-stream\r\n"
+            "\r\n",
+            boundary, key, filename);
+    }
+
+    void MultipartBuilder::flush_text()
+    {
+        if (str_.empty()) return;
+        texts_.push_back(clu::take(str_));
+        parts_.emplace_back(texts_.back());
+    }
+
     void MultipartBuilder::add_key_value(const std::string_view key, const std::string_view value)
     {
         str_ += fmt::format("\r\n"
@@ -18,29 +36,45 @@ namespace mpp::detail
 
     void MultipartBuilder::add_file(const std::string_view key, const std::filesystem::path& path)
     {
-        std::ifstream fs(path, std::ios::in | std::ios::binary);
-        if (fs.fail()) throw std::runtime_error("failed to open binary file");
+        const MappedFile file(path);
+        add_file_content(key, path.filename().string(), file.view());
+    }
 
-        str_ += fmt::format("\r\n"
-            "--{}\r\n"
-            "Content-Disposition: form-data; name=\"{}\"; filename=\"{}\"\r\n"
-            "Content-Type: application/octet-stream\r\n"
-            "\r\n",
-            boundary, key, path.filename().string());
+    void MultipartBuilder::add_file_content(
+        const std::string_view key, const std::string_view filename, const std::string_view content)
+    {
+        str_.reserve(str_.size() + content.size() + 256);
+        add_file_header(key, filename);
+        str_ += content;
+    }
 
-        fs.ignore(std::numeric_limits<std::streamsize>::max());
-        const std::streamsize size = fs.gcount();
-        str_.reserve(str_.size() + size + closing_boundary.size());
-        char* data = str_.data() + str_.size();
-        str_.resize(str_.size() + size);
-        fs.seekg(0, std::ios::beg);
-        fs.read(data, size);
-        if (fs.fail() && !fs.eof()) throw std::runtime_error("failed to read binary file");
+    void MultipartBuilder::add_file_view(
+        const std::string_view key, const std::string_view filename, const std::string_view content)
+    {
+        add_file_header(key, filename);
+        flush_text();
+        parts_.push_back(content);
     }
 
     std::string MultipartBuilder::take_string()
     {
         str_ += closing_boundary;
-        return clu::take(str_);
+        if (parts_.empty()) return clu::take(str_);
+        flush_text();
+        std::string result;
+        size_t size = 0;
+        for (const auto part : parts_) size += part.size();
+        result.reserve(size);
+        for (const auto part : parts_) result += part;
+        parts_.clear();
+        texts_.clear();
+        return result;
+    }
+
+    std::vector<std::string_view> MultipartBuilder::take_parts()
+    {
+        str_ += closing_boundary;
+        flush_text();
+        return clu::take(parts_);
     }
 }
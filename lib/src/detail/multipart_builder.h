@@ -1,6 +1,8 @@
 #pragma once
 
+#include <deque>
 #include <string>
+#include <vector>
 #include <filesystem>
 
 namespace mpp::detail
@@ -16,10 +18,20 @@ namespace mpp::detail
 
     private:
         std::string str_;
+        std::deque<std::string> texts_; // Finished text parts, a deque never relocates its elements
+        std::vector<std::string_view> parts_;
+
+        void add_file_header(std::string_view key, std::string_view filename);
+        void flush_text();
 
     public:
         void add_key_value(std::string_view key, std::string_view value);
         void add_file(std::string_view key, const std::filesystem::path& path);
+        void add_file_content(std::string_view key, std::string_view filename, std::string_view content);
+        // Adds a file part without copying, the content must outlive the buffers returned by take_parts
+        void add_file_view(std::string_view key, std::string_view filename, std::string_view content);
         std::string take_string();
+        // Returns the body as a sequence of buffers, which refer to this builder and to the viewed file contents
+        std::vector<std::string_view> take_parts();
     };
 }
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+namespace mpp::detail
+{
+    // A set remembering only the most recently inserted keys, older keys are forgotten in insertion order
+    class RecentSet final
+    {
+    private:
+        std::vector<uint64_t> ring_;
+        size_t next_ = 0;
+        std::unordered_set<uint64_t> set_;
+
+    public:
+        explicit RecentSet(const size_t capacity) { ring_.reserve(capacity); set_.reserve(capacity); }
+
+        // Returns false if the key is already in the set
+        bool insert(const uint64_t key)
+        {
+            if (ring_.capacity() == 0) return true;
+            if (!set_.insert(key).second) return false;
+            if (ring_.size() < ring_.capacity())
+                ring_.push_back(key);
+            else
+            {
+                set_.erase(ring_[next_]);
+                ring_[next_] = key;
+                next_ = (next_ + 1) % ring_.size();
+            }
+            return true;
+        }
+    };
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace mpp::detail
+{
+    using Sha256Digest = std::array<uint8_t, 32>;
+
+    // SHA-256 (FIPS 180-4) of a byte string, for telling contents apart where a collision must not happen in practice
+    Sha256Digest sha256(std::string_view data) noexcept;
+}
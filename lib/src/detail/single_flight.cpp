@@ -0,0 +1,110 @@
+#include "mirai/detail/single_flight.h"
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <unifex/with_query_value.hpp>
+#include <unifex/transform_done.hpp>
+
+#include "mirai/detail/ex_utils.h"
+
+namespace mpp::detail
+{
+    bool SingleFlight::Waiter::await_suspend(const std::coroutine_handle<> hdl) noexcept
+    {
+        handle = hdl;
+        return !suspended.exchange(true, std::memory_order_acq_rel);
+    }
+
+    void SingleFlight::complete(Waiter& waiter)
+    {
+        if (waiter.suspended.exchange(true, std::memory_order_acq_rel))
+            post(sch_.io_context(), [handle = waiter.handle] { handle.resume(); });
+    }
+
+    void SingleFlight::leave(const std::string& key, Waiter& waiter)
+    {
+        {
+            std::unique_lock lock(mutex_);
+            if (!waiter.flight) return; // Already taken off the list by the leader
+            Flight& flight = *waiter.flight;
+            Waiter** link = &flight.waiters;
+            while (*link != &waiter) link = &(*link)->next;
+            *link = waiter.next;
+            waiter.flight = nullptr;
+            waiter.done = true;
+            abandon_if_unused(key, flight);
+        }
+        complete(waiter);
+    }
+
+    void SingleFlight::abandon_if_unused(const std::string& key, Flight& flight)
+    {
+        // Called under the lock, which also keeps the leader from destroying the flight in the meantime
+        if (!flight.leader_cancelled || flight.waiters) return;
+        if (const auto iter = flights_.find(key); iter != flights_.end() && iter->second == &flight)
+            flights_.erase(iter); // New callers start a new flight instead of joining a cancelled one
+        flight.stop.request_stop();
+    }
+
+    ex::task<std::string> SingleFlight::run(std::string key, const clu::function_ref<ex::task<std::string>()> request)
+    {
+        const auto stop_token = co_await ex::get_stop_token();
+        std::unique_lock lock(mutex_);
+        if (const auto iter = flights_.find(key); iter != flights_.end())
+        {
+            Waiter waiter{ .flight = iter->second, .next = iter->second->waiters };
+            iter->second->waiters = &waiter;
+            lock.unlock();
+            {
+                const auto callback = make_stop_callback(stop_token, [&] { leave(key, waiter); });
+                co_await waiter;
+            }
+            if (waiter.done) co_await ex::stop();
+            waiter.result.throw_if_exceptional();
+            co_return *std::move(waiter.result);
+        }
+        Flight flight;
+        flights_.emplace(key, &flight);
+        lock.unlock();
+
+        // The request is shared by all the waiters, so the leader's stop request alone should not cancel it
+        clu::outcome<std::string> result;
+        bool done = false;
+        {
+            const auto callback = make_stop_callback(stop_token, [&]
+            {
+                std::unique_lock guard(mutex_);
+                flight.leader_cancelled = true;
+                abandon_if_unused(key, flight);
+            });
+            try
+            {
+                result = co_await (
+                    ex::with_query_value(request(), ex::get_stop_token, flight.stop.get_token())
+                    | ex::transform_done([&] { done = true; return ex::just(std::string()); })
+                );
+            }
+            catch (...) { result = std::current_exception(); }
+        }
+
+        lock.lock();
+        if (const auto iter = flights_.find(key); iter != flights_.end() && iter->second == &flight)
+            flights_.erase(iter);
+        Waiter* waiter = std::exchange(flight.waiters, nullptr);
+        for (Waiter* ptr = waiter; ptr; ptr = ptr->next) ptr->flight = nullptr;
+        lock.unlock();
+
+        while (waiter)
+        {
+            Waiter* next = waiter->next; // The waiter is destroyed after resumption
+            if (done) waiter->done = true;
+            else waiter->result = result;
+            complete(*waiter);
+            waiter = next;
+        }
+
+        if (done || stop_token.stop_requested()) co_await ex::stop();
+        result.throw_if_exceptional();
+        co_return *std::move(result);
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+
+namespace mpp::detail
+{
+    // 64-bit FNV-1a over a byte stream, the results are the same across platforms and runs
+    class StableHasher
+    {
+    private:
+        uint64_t hash_ = 14695981039346656037ull;
+
+        void update_bytes(const std::string_view bytes) noexcept
+        {
+            for (const char c : bytes)
+            {
+                hash_ ^= static_cast<uint8_t>(c);
+                hash_ *= 1099511628211ull;
+            }
+        }
+
+    public:
+        // Little-endian regardless of the platform
+        template <typename T> requires std::is_integral_v<T> || std::is_enum_v<T>
+        void update(const T value) noexcept
+        {
+            auto bits = static_cast<uint64_t>(value);
+            for (size_t i = 0; i < sizeof(T); i++, bits >>= 8)
+            {
+                hash_ ^= static_cast<uint8_t>(bits);
+                hash_ *= 1099511628211ull;
+            }
+        }
+
+        // Length-prefixed, so that adjacent strings cannot run into each other
+        void update(const std::string_view str) noexcept
+        {
+            update(static_cast<uint64_t>(str.size()));
+            update_bytes(str);
+        }
+
+        template <typename T>
+        void update(const std::optional<T>& opt) noexcept
+        {
+            update(opt.has_value());
+            if (opt) update(*opt);
+        }
+
+        void update_raw(const std::string_view bytes) noexcept { update_bytes(bytes); }
+
+        uint64_t value() const noexcept { return hash_; }
+    };
+}
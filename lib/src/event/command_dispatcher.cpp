@@ -0,0 +1,106 @@
+#include "mirai/event/command_dispatcher.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "mirai/event/event_types.h"
+
+namespace mpp
+{
+    void CommandDispatcher::release(const size_t index)
+    {
+        Slot& slot = slots_[index];
+        if (--slot.aliases != 0) return;
+        slot.handler.reset();
+        free_slots_.push_back(index);
+    }
+
+    void CommandDispatcher::add(const std::initializer_list<std::string_view> names, Handler handler)
+    {
+        if (!std::ranges::all_of(names, CommandTrie::is_valid_key))
+            throw std::invalid_argument("命令词不能为空，也不能包含空白字符");
+        if (names.size() == 0) return;
+        auto ptr = std::make_shared<const Handler>(std::move(handler));
+
+        std::unique_lock lock(mutex_);
+        size_t index;
+        if (free_slots_.empty())
+        {
+            index = slots_.size();
+            slots_.emplace_back();
+        }
+        else
+        {
+            index = free_slots_.back();
+            free_slots_.pop_back();
+        }
+        slots_[index].handler = std::move(ptr);
+        for (const std::string_view name : names)
+        {
+            const auto old = trie_.find(name);
+            if (old == index) continue; // Duplicated alias in the same list
+            trie_.insert(name, index);
+            slots_[index].aliases++;
+            if (old) release(*old);
+        }
+    }
+
+    bool CommandDispatcher::remove(const std::string_view name)
+    {
+        std::unique_lock lock(mutex_);
+        const auto index = trie_.find(name);
+        if (!index) return false;
+        trie_.erase(name);
+        release(*index);
+        return true;
+    }
+
+    bool CommandDispatcher::contains(const std::string_view name) const
+    {
+        std::shared_lock lock(mutex_);
+        return trie_.find(name).has_value();
+    }
+
+    size_t CommandDispatcher::size() const
+    {
+        std::shared_lock lock(mutex_);
+        return trie_.size();
+    }
+
+    ex::task<bool> CommandDispatcher::dispatch(const Event& ev) const
+    {
+        const MessageEventBase* base = ev.visit(overloaded
+        {
+            [](const MessageEventBase& msg) -> const MessageEventBase* { return &msg; },
+            [](const EventBase&) -> const MessageEventBase* { return nullptr; }
+        });
+        if (!base) co_return false;
+        const Message& content = base->msg.content;
+        if (content.empty()) co_return false;
+        const auto* plain = content.front().get_if<Plain>();
+        if (!plain) co_return false;
+
+        const std::string_view text = plain->text;
+        std::shared_ptr<const Handler> handler;
+        size_t length = 0;
+        {
+            std::shared_lock lock(mutex_);
+            const auto match = trie_.match(text);
+            if (!match) co_return false;
+            handler = slots_[match->value].handler;
+            length = match->length;
+        }
+
+        const size_t args_begin = std::min(text.find_first_not_of(" \t\r\n", length), text.size());
+        const CommandArgs args
+        {
+            .command = text.substr(0, length),
+            .text = text.substr(args_begin),
+            .rest = std::span(content.data() + 1, content.size() - 1)
+        };
+        co_await (*handler)(ev, args);
+        co_return true;
+    }
+
+    ex::task<void> CommandDispatcher::operator()(const Event& ev) const { (void)co_await dispatch(ev); }
+}
@@ -0,0 +1,128 @@
+#include "mirai/event/event_router.h"
+
+#include <algorithm>
+
+#include "mirai/event/event_types.h"
+
+namespace mpp
+{
+    namespace
+    {
+        struct EventKeys
+        {
+            std::optional<GroupId> group;
+            std::optional<UserId> sender;
+            std::string_view command;
+        };
+
+        // The command word is the leading plain text of the message up to the first whitespace
+        std::string_view command_of(const Message& msg)
+        {
+            if (msg.empty()) return {};
+            const auto* ptr = msg.front().get_if<Plain>();
+            if (!ptr) return {};
+            const std::string_view text = ptr->text;
+            return text.substr(0, text.find_first_of(" \t\r\n"));
+        }
+
+        EventKeys event_keys(const Event& ev)
+        {
+            return ev.visit(overloaded
+            {
+                [](const FriendMessageEvent& e) { return EventKeys{ {}, e.sender.id, command_of(e.msg.content) }; },
+                [](const GroupMessageEvent& e) { return EventKeys{ e.sender.group.id, e.sender.id, command_of(e.msg.content) }; },
+                [](const TempMessageEvent& e) { return EventKeys{ e.sender.group.id, e.sender.id, command_of(e.msg.content) }; },
+                [](const GroupRecallEvent& e) { return EventKeys{ e.group.id, e.sender_id }; },
+                [](const FriendRecallEvent& e) { return EventKeys{ {}, e.sender_id }; },
+                [](const GroupEventBase& e) { return EventKeys{ e.group.id }; },
+                [](const ExecutorEventBase& e) { return EventKeys{ e.executor.group.id }; },
+                [](const MemberEventBase& e) { return EventKeys{ e.member.group.id, e.member.id }; },
+                [](const NewFriendRequestEvent& e) { return EventKeys{ e.group_id, e.from_id }; },
+                [](const MemberJoinRequestEvent& e) { return EventKeys{ e.group_id, e.from_id }; },
+                [](const BotInvitedJoinGroupRequestEvent& e) { return EventKeys{ e.group_id, e.from_id }; },
+                [](const EventBase&) { return EventKeys{}; }
+            });
+        }
+
+        bool route_matches(const EventRoute& route, const EventKeys& keys)
+        {
+            if (route.group && route.group != keys.group) return false;
+            if (route.sender && route.sender != keys.sender) return false;
+            if (!route.command.empty() && route.command != keys.command) return false;
+            return true;
+        }
+    }
+
+    std::vector<EventRouter::HandlerId>& EventRouter::index_of(const EventRoute& route)
+    {
+        Bucket& bucket = buckets_[static_cast<size_t>(route.type)];
+        if (!route.command.empty()) return bucket.by_command[route.command];
+        if (route.sender) return bucket.by_sender[route.sender->id];
+        if (route.group) return bucket.by_group[route.group->id];
+        return bucket.any;
+    }
+
+    EventRouter::HandlerId EventRouter::add(EventRoute route, Handler handler)
+    {
+        if (static_cast<size_t>(route.type) >= event_type_count) throw std::runtime_error("无效的事件类型");
+        std::unique_lock lock(mutex_);
+        const HandlerId id = entries_.size();
+        index_of(route).push_back(id);
+        entries_.emplace_back(Entry{ std::move(route), std::make_shared<const Handler>(std::move(handler)) });
+        size_++;
+        return id;
+    }
+
+    bool EventRouter::remove(const HandlerId id)
+    {
+        std::unique_lock lock(mutex_);
+        if (id >= entries_.size() || !entries_[id]) return false;
+        std::erase(index_of(entries_[id]->route), id);
+        entries_[id].reset();
+        size_--;
+        return true;
+    }
+
+    size_t EventRouter::size() const
+    {
+        std::shared_lock lock(mutex_);
+        return size_;
+    }
+
+    std::vector<std::shared_ptr<const EventRouter::Handler>> EventRouter::match(const Event& ev) const
+    {
+        const EventKeys keys = event_keys(ev);
+        std::shared_lock lock(mutex_);
+        const Bucket& bucket = buckets_[static_cast<size_t>(ev.type())];
+
+        std::vector<HandlerId> ids;
+        const auto collect = [&](const std::vector<HandlerId>& candidates)
+        {
+            for (const HandlerId id : candidates)
+                if (route_matches(entries_[id]->route, keys))
+                    ids.push_back(id);
+        };
+        const auto collect_key = [&](const auto& map, const auto& key)
+        {
+            if (const auto iter = map.find(key); iter != map.end()) collect(iter->second);
+        };
+        collect(bucket.any);
+        if (keys.group) collect_key(bucket.by_group, keys.group->id);
+        if (keys.sender) collect_key(bucket.by_sender, keys.sender->id);
+        if (!keys.command.empty()) collect_key(bucket.by_command, keys.command);
+
+        // Ids are given out in increasing order, so sorting restores the registration order
+        std::ranges::sort(ids);
+        std::vector<std::shared_ptr<const Handler>> handlers;
+        handlers.reserve(ids.size());
+        for (const HandlerId id : ids) handlers.push_back(entries_[id]->handler);
+        return handlers;
+    }
+
+    ex::task<void> EventRouter::dispatch(const Event& ev) const
+    {
+        // The handlers are kept alive by the shared pointers even if they are removed meanwhile
+        for (const auto handlers = match(ev); const auto& handler : handlers)
+            co_await (*handler)(ev);
+    }
+}
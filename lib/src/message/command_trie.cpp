@@ -0,0 +1,126 @@
+#include "mirai/message/command_trie.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace mpp
+{
+    namespace
+    {
+        bool is_space(const char ch) noexcept { return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n'; }
+    }
+
+    std::vector<CommandTrie::Node>::iterator CommandTrie::find_child(Node& node, const char first) noexcept
+    {
+        return std::ranges::lower_bound(node.children, first, {},
+            [](const Node& child) { return child.label.front(); });
+    }
+
+    const CommandTrie::Node* CommandTrie::find_child(const Node& node, const char first) noexcept
+    {
+        const auto iter = std::ranges::lower_bound(node.children, first, {},
+            [](const Node& child) { return child.label.front(); });
+        if (iter == node.children.end() || iter->label.front() != first) return nullptr;
+        return &*iter;
+    }
+
+    CommandTrie::Node* CommandTrie::find_node(std::string_view key) noexcept
+    {
+        Node* node = &root_;
+        while (!key.empty())
+        {
+            const auto iter = find_child(*node, key.front());
+            if (iter == node->children.end() || !key.starts_with(iter->label)) return nullptr;
+            key.remove_prefix(iter->label.size());
+            node = &*iter;
+        }
+        return node;
+    }
+
+    bool CommandTrie::is_valid_key(const std::string_view key) noexcept
+    {
+        return !key.empty() && std::ranges::none_of(key, is_space);
+    }
+
+    void CommandTrie::insert(std::string_view key, const size_t value)
+    {
+        if (!is_valid_key(key))
+            throw std::invalid_argument("命令词不能为空，也不能包含空白字符");
+        Node* node = &root_;
+        while (true)
+        {
+            const auto iter = find_child(*node, key.front());
+            if (iter == node->children.end() || iter->label.front() != key.front())
+            {
+                node->children.insert(iter, Node{ .label = std::string(key), .value = value });
+                size_++;
+                return;
+            }
+
+            const auto [label_end, key_end] = std::ranges::mismatch(iter->label, key);
+            const auto common = static_cast<size_t>(label_end - iter->label.begin());
+            if (common < iter->label.size())
+            {
+                // Split the edge at the end of the common prefix
+                Node child = std::move(*iter);
+                Node middle{ .label = child.label.substr(0, common) };
+                child.label.erase(0, common);
+                middle.children.push_back(std::move(child));
+                *iter = std::move(middle);
+            }
+            key.remove_prefix(common);
+            node = &*iter;
+            if (key.empty())
+            {
+                if (!node->value) size_++;
+                node->value = value;
+                return;
+            }
+        }
+    }
+
+    bool CommandTrie::erase(const std::string_view key)
+    {
+        // Emptied nodes are left in place, they only cost a few extra steps when matching
+        Node* node = key.empty() ? nullptr : find_node(key);
+        if (!node || !node->value) return false;
+        node->value.reset();
+        size_--;
+        return true;
+    }
+
+    std::optional<size_t> CommandTrie::find(std::string_view key) const
+    {
+        if (key.empty()) return std::nullopt;
+        const Node* node = &root_;
+        while (!key.empty())
+        {
+            node = find_child(*node, key.front());
+            if (!node || !key.starts_with(node->label)) return std::nullopt;
+            key.remove_prefix(node->label.size());
+        }
+        return node->value;
+    }
+
+    std::optional<CommandTrie::Match> CommandTrie::match(const std::string_view text) const
+    {
+        std::optional<Match> best;
+        const Node* node = &root_;
+        size_t pos = 0;
+        while (pos < text.size())
+        {
+            node = find_child(*node, text[pos]);
+            if (!node || !text.substr(pos).starts_with(node->label)) break;
+            pos += node->label.size();
+            if (node->value && (pos == text.size() || is_space(text[pos])))
+                best = Match{ .value = *node->value, .length = pos };
+        }
+        return best;
+    }
+
+    void CommandTrie::clear() noexcept
+    {
+        root_.children.clear();
+        size_ = 0;
+    }
+}
@@ -0,0 +1,184 @@
+#include "mirai/message/keyword_matcher.h"
+
+#include <algorithm>
+#include <deque>
+#include <map>
+
+namespace mpp
+{
+    KeywordSet::KeywordSet(std::vector<std::string> patterns): patterns_(std::move(patterns))
+    {
+        // Build the trie with ordered maps first, then flatten it into contiguous arrays
+        struct BuildState
+        {
+            std::map<uint8_t, uint32_t> next;
+            std::vector<uint32_t> outputs;
+            uint32_t fail = 0;
+        };
+        std::vector<BuildState> build(1);
+        for (size_t id = 0; id < patterns_.size(); id++)
+        {
+            uint32_t state = 0;
+            for (const char ch : patterns_[id])
+            {
+                const auto byte = static_cast<uint8_t>(ch);
+                if (const auto iter = build[state].next.find(byte); iter != build[state].next.end())
+                    state = iter->second;
+                else
+                {
+                    const auto next = static_cast<uint32_t>(build.size());
+                    build[state].next.emplace(byte, next);
+                    build.emplace_back();
+                    state = next;
+                }
+            }
+            if (state != 0) build[state].outputs.push_back(static_cast<uint32_t>(id));
+        }
+
+        // Breadth-first, so that the failure link of a state is final before its children are visited
+        std::deque<uint32_t> queue;
+        for (const auto& [byte, child] : build[0].next) queue.push_back(child);
+        while (!queue.empty())
+        {
+            const uint32_t state = queue.front();
+            queue.pop_front();
+            for (const auto& [byte, child] : build[state].next)
+            {
+                uint32_t fail = build[state].fail;
+                while (true)
+                {
+                    if (const auto iter = build[fail].next.find(byte); iter != build[fail].next.end())
+                    {
+                        fail = iter->second;
+                        break;
+                    }
+                    if (fail == 0) break;
+                    fail = build[fail].fail;
+                }
+                build[child].fail = fail;
+                const auto& inherited = build[fail].outputs;
+                build[child].outputs.insert(build[child].outputs.end(), inherited.begin(), inherited.end());
+                queue.push_back(child);
+            }
+        }
+
+        states_.resize(build.size());
+        for (size_t i = 0; i < build.size(); i++)
+        {
+            State& state = states_[i];
+            state.fail = build[i].fail;
+            state.edges_begin = static_cast<uint32_t>(edges_.size());
+            for (const auto& [byte, child] : build[i].next) edges_.push_back({ byte, child });
+            state.edges_end = static_cast<uint32_t>(edges_.size());
+            state.outputs_begin = static_cast<uint32_t>(outputs_.size());
+            outputs_.insert(outputs_.end(), build[i].outputs.begin(), build[i].outputs.end());
+            state.outputs_end = static_cast<uint32_t>(outputs_.size());
+        }
+        for (const auto& [byte, child] : build[0].next) root_next_[byte] = child;
+    }
+
+    uint32_t KeywordSet::next_state(uint32_t state, const uint8_t byte) const noexcept
+    {
+        while (state != 0)
+        {
+            const State& s = states_[state];
+            const auto first = edges_.begin() + s.edges_begin;
+            const auto last = edges_.begin() + s.edges_end;
+            if (const auto iter = std::lower_bound(first, last, byte,
+                [](const Edge& edge, const uint8_t b) { return edge.byte < b; });
+                iter != last && iter->byte == byte)
+                return iter->target;
+            state = s.fail;
+        }
+        return root_next_[byte];
+    }
+
+    // on_match returns false to stop the scan, the returned state is then the stopping state
+    template <typename F>
+    uint32_t KeywordSet::scan(uint32_t state, const std::string_view text, F&& on_match) const
+    {
+        if (states_.size() <= 1) return 0;
+        for (const char ch : text)
+        {
+            state = next_state(state, static_cast<uint8_t>(ch));
+            const State& s = states_[state];
+            for (uint32_t i = s.outputs_begin; i < s.outputs_end; i++)
+                if (!on_match(outputs_[i])) return state;
+        }
+        return state;
+    }
+
+    template <typename F>
+    void KeywordSet::scan(const Message& msg, F&& on_match) const
+    {
+        bool stopped = false;
+        const auto wrapped = [&](const uint32_t id)
+        {
+            stopped = !on_match(id);
+            return !stopped;
+        };
+        uint32_t state = 0;
+        for (const Segment& seg : msg)
+        {
+            if (const auto* plain = seg.get_if<Plain>())
+            {
+                state = scan(state, plain->text, wrapped);
+                if (stopped) return;
+            }
+            else
+                state = 0;
+        }
+    }
+
+    bool KeywordSet::contains_any_sv(const std::string_view text) const
+    {
+        bool found = false;
+        (void)scan(0, text, [&](uint32_t) { found = true; return false; });
+        return found;
+    }
+
+    std::vector<size_t> KeywordSet::match_sv(const std::string_view text) const
+    {
+        std::vector<size_t> ids;
+        (void)scan(0, text, [&](const uint32_t id) { ids.push_back(id); return true; });
+        std::ranges::sort(ids);
+        ids.erase(std::ranges::unique(ids).begin(), ids.end());
+        return ids;
+    }
+
+    bool KeywordSet::contains_any(const Message& msg) const
+    {
+        bool found = false;
+        scan(msg, [&](uint32_t) { found = true; return false; });
+        return found;
+    }
+
+    std::vector<size_t> KeywordSet::match(const Message& msg) const
+    {
+        std::vector<size_t> ids;
+        scan(msg, [&](const uint32_t id) { ids.push_back(id); return true; });
+        std::ranges::sort(ids);
+        ids.erase(std::ranges::unique(ids).begin(), ids.end());
+        return ids;
+    }
+
+    void KeywordMatcher::reset(std::vector<std::string> patterns)
+    {
+        reset(std::make_shared<const KeywordSet>(std::move(patterns)));
+    }
+
+    void KeywordMatcher::reset(std::shared_ptr<const KeywordSet> set)
+    {
+        if (!set) set = std::make_shared<const KeywordSet>();
+        std::unique_lock lock(mutex_);
+        set_.swap(set);
+        // The old set is released after unlocking, in case this was the last reference
+        lock.unlock();
+    }
+
+    std::shared_ptr<const KeywordSet> KeywordMatcher::snapshot() const
+    {
+        std::unique_lock lock(mutex_);
+        return set_;
+    }
+}
@@ -2,6 +2,7 @@
 
 #include "mirai/message/forwarded_message.h"
 #include "../detail/json.h"
+#include "../detail/stable_hash.h"
 
 namespace mpp
 {
@@ -49,7 +50,7 @@ namespace mpp
     void Message::collapse_adjacent_text()
     {
         std::vector<Segment> result;
-        for (Segment& segment : vec_)
+        for (Segment& segment : mutable_vec())
         {
             if (const auto* ptr = segment.get_if<Plain>();
                 ptr && !result.empty())
@@ -86,6 +87,115 @@ namespace mpp
         return result;
     }
 
+    namespace
+    {
+        // Converts full-width ASCII (U+FF01 to U+FF5E) and the ideographic space (U+3000) to half-width,
+        // and ASCII letters to lower case
+        void append_normalized(std::string& out, const std::string_view text)
+        {
+            for (size_t i = 0; i < text.size(); i++)
+            {
+                const auto byte = static_cast<uint8_t>(text[i]);
+                if (byte < 0x80)
+                {
+                    out += (byte >= 'A' && byte <= 'Z') ? static_cast<char>(byte - 'A' + 'a') : text[i];
+                    continue;
+                }
+                if (i + 2 < text.size())
+                {
+                    const auto b1 = static_cast<uint8_t>(text[i + 1]);
+                    const auto b2 = static_cast<uint8_t>(text[i + 2]);
+                    uint32_t code = 0;
+                    if (byte == 0xef && (b1 == 0xbc || b1 == 0xbd) && (b2 & 0xc0) == 0x80)
+                        code = 0xff00 + ((b1 & 0x03u) << 6) + (b2 & 0x3fu);
+                    if (code >= 0xff01 && code <= 0xff5e)
+                    {
+                        const auto ch = static_cast<char>(code - 0xff01 + 0x21);
+                        out += (ch >= 'A' && ch <= 'Z') ? static_cast<char>(ch - 'A' + 'a') : ch;
+                        i += 2;
+                        continue;
+                    }
+                    if (byte == 0xe3 && b1 == 0x80 && b2 == 0x80)
+                    {
+                        out += ' ';
+                        i += 2;
+                        continue;
+                    }
+                }
+                out += text[i];
+            }
+        }
+    }
+
+    MessageDerivedData MessageDerivedData::compute(const std::vector<Segment>& segments)
+    {
+        MessageDerivedData data;
+        detail::StableHasher hasher;
+        hasher.update(static_cast<uint64_t>(segments.size()));
+        for (const Segment& seg : segments)
+        {
+            data.segment_counts[static_cast<size_t>(seg.type())]++;
+            hasher.update(seg.content_hash());
+            if (const auto* ptr = seg.get_if<Plain>())
+            {
+                data.text += ptr->text;
+                append_normalized(data.normalized_text, ptr->text);
+            }
+        }
+        data.content_hash = hasher.value();
+        return data;
+    }
+
+    namespace
+    {
+        class SpinLockGuard
+        {
+        private:
+            std::atomic_flag& flag_;
+
+        public:
+            explicit SpinLockGuard(std::atomic_flag& flag) noexcept: flag_(flag)
+            {
+                while (flag_.test_and_set(std::memory_order_acquire))
+                    flag_.wait(true, std::memory_order_relaxed);
+            }
+
+            ~SpinLockGuard() noexcept
+            {
+                flag_.clear(std::memory_order_release);
+                flag_.notify_one();
+            }
+
+            SpinLockGuard(const SpinLockGuard&) = delete;
+            SpinLockGuard& operator=(const SpinLockGuard&) = delete;
+        };
+    }
+
+    std::shared_ptr<const MessageDerivedData> Message::load_derived() const noexcept
+    {
+        SpinLockGuard guard(derived_lock_);
+        return derived_;
+    }
+
+    std::shared_ptr<const MessageDerivedData> Message::exchange_derived(std::shared_ptr<const MessageDerivedData> ptr) noexcept
+    {
+        {
+            SpinLockGuard guard(derived_lock_);
+            derived_.swap(ptr);
+        }
+        return ptr; // The old data is released outside of the lock
+    }
+
+    std::shared_ptr<const MessageDerivedData> Message::derived() const
+    {
+        if (auto ptr = load_derived()) return ptr;
+        // Racing threads may each compute the data, but only the first result is kept and shared
+        auto computed = std::make_shared<const MessageDerivedData>(MessageDerivedData::compute(vec_));
+        SpinLockGuard guard(derived_lock_);
+        if (!derived_) derived_ = std::move(computed);
+        return derived_;
+    }
+
     void Message::format_to(fmt::format_context& ctx) const
     {
         for (const Segment& seg : vec_)
@@ -0,0 +1,39 @@
+#include "mirai/message/message_tokenizer.h"
+
+namespace mpp
+{
+    namespace
+    {
+        constexpr std::string_view whitespace = " \t\r\n";
+    }
+
+    std::optional<MessageToken> MessageTokenizer::next() noexcept
+    {
+        while (true)
+        {
+            text_.remove_prefix(std::min(text_.find_first_not_of(whitespace), text_.size()));
+            if (!text_.empty()) break;
+            if (seg_ == end_) return std::nullopt;
+            const Segment& seg = *seg_++;
+            if (const auto* plain = seg.get_if<Plain>())
+                text_ = plain->text;
+            else
+                return MessageToken{ .segment = &seg };
+        }
+
+        if (options_.quotes && (text_.front() == '"' || text_.front() == '\''))
+        {
+            // An unclosed quote takes the rest of the text in this segment
+            const size_t close = text_.find(text_.front(), 1);
+            const size_t length = std::min(close, text_.size()) - 1;
+            const MessageToken token{ .text = text_.substr(1, length), .quoted = true };
+            text_.remove_prefix(std::min(length + 2, text_.size()));
+            return token;
+        }
+
+        const size_t length = std::min(text_.find_first_of(whitespace), text_.size());
+        const MessageToken token{ .text = text_.substr(0, length) };
+        text_.remove_prefix(length);
+        return token;
+    }
+}
@@ -1,9 +1,12 @@
 #include "mirai/message/segment.h"
 
+#include <algorithm>
+#include <utility>
 #include <clu/hash.h>
 
 #include "mirai/message/forwarded_message.h"
 #include "../detail/json.h"
+#include "../detail/stable_hash.h"
 
 namespace mpp
 {
@@ -14,6 +17,127 @@ namespace mpp
         return false;
     }
 
+    namespace
+    {
+        // Images and voices are identified by their id, or by the url or the path when there is no id
+        std::pair<uint8_t, const std::optional<std::string>*> canonical_identity(
+            const std::optional<std::string>& id, const std::optional<std::string>& url,
+            const std::optional<std::string>& path) noexcept
+        {
+            if (id) return { 0, &id };
+            if (url) return { 1, &url };
+            return { 2, &path };
+        }
+
+        template <typename T>
+        std::pair<uint8_t, const std::optional<std::string>*> canonical_identity(const T& media) noexcept
+        {
+            if constexpr (std::is_same_v<T, Voice>)
+                return canonical_identity(media.voice_id, media.url, media.path);
+            else
+                return canonical_identity(media.image_id, media.url, media.path);
+        }
+
+        template <typename T>
+        void hash_media(detail::StableHasher& hasher, const T& media)
+        {
+            const auto [kind, value] = canonical_identity(media);
+            hasher.update(kind);
+            hasher.update(*value);
+        }
+
+        template <typename T>
+        bool same_media(const T& lhs, const T& rhs) noexcept
+        {
+            const auto [lhs_kind, lhs_value] = canonical_identity(lhs);
+            const auto [rhs_kind, rhs_value] = canonical_identity(rhs);
+            return lhs_kind == rhs_kind && *lhs_value == *rhs_value;
+        }
+
+        // A face is identified by its id, or by its name when there is no id
+        void hash_face(detail::StableHasher& hasher, const Face& face)
+        {
+            hasher.update(face.face_id.has_value());
+            if (face.face_id) hasher.update(*face.face_id);
+            else hasher.update(face.name);
+        }
+
+        bool same_face(const Face& lhs, const Face& rhs) noexcept
+        {
+            if (lhs.face_id.has_value() != rhs.face_id.has_value()) return false;
+            return lhs.face_id ? *lhs.face_id == *rhs.face_id : lhs.name == rhs.name;
+        }
+
+        void hash_forward(detail::StableHasher& hasher, const Forward& forward)
+        {
+            hasher.update(forward.title);
+            hasher.update(forward.brief);
+            hasher.update(forward.source);
+            hasher.update(forward.summary);
+            hasher.update(static_cast<uint64_t>(forward.messages.size()));
+            for (const ForwardedMessage& msg : forward.messages)
+            {
+                hasher.update(msg.sender.id);
+                hasher.update(msg.time);
+                hasher.update(msg.sender_name);
+                hasher.update(msg.content.content_hash());
+            }
+        }
+
+        bool same_forward(const Forward& lhs, const Forward& rhs)
+        {
+            return lhs.title == rhs.title && lhs.brief == rhs.brief
+                && lhs.source == rhs.source && lhs.summary == rhs.summary
+                && std::ranges::equal(lhs.messages, rhs.messages,
+                    [](const ForwardedMessage& l, const ForwardedMessage& r)
+                    {
+                        return l.sender == r.sender && l.time == r.time
+                            && l.sender_name == r.sender_name && l.content.same_content(r.content);
+                    });
+        }
+    }
+
+    uint64_t Segment::content_hash() const
+    {
+        detail::StableHasher hasher;
+        hasher.update(type());
+        // @formatter:off
+        switch (type())
+        {
+            case SegmentType::at:          hasher.update(get<At>().target.id); break;
+            case SegmentType::at_all:      break;
+            case SegmentType::face:        hash_face(hasher, get<Face>()); break;
+            case SegmentType::plain:       hasher.update(get<Plain>().text); break;
+            case SegmentType::image:       hash_media(hasher, get<Image>()); break;
+            case SegmentType::flash_image: hash_media(hasher, get<FlashImage>()); break;
+            case SegmentType::voice:       hash_media(hasher, get<Voice>()); break;
+            case SegmentType::xml:         hasher.update(get<Xml>().xml); break;
+            case SegmentType::json:        hasher.update(get<Json>().json); break;
+            case SegmentType::app:         hasher.update(get<App>().content); break;
+            case SegmentType::poke:        hasher.update(get<Poke>().name); break;
+            case SegmentType::forward:     hash_forward(hasher, get<Forward>()); break;
+            case SegmentType::file:        break;
+        }
+        // @formatter:on
+        return hasher.value();
+    }
+
+    bool Segment::same_content(const Segment& other) const
+    {
+        if (type() != other.type()) return false;
+        // @formatter:off
+        switch (type())
+        {
+            case SegmentType::face:        return same_face(get<Face>(), other.get<Face>());
+            case SegmentType::image:       return same_media(get<Image>(), other.get<Image>());
+            case SegmentType::flash_image: return same_media(get<FlashImage>(), other.get<FlashImage>());
+            case SegmentType::voice:       return same_media(get<Voice>(), other.get<Voice>());
+            case SegmentType::forward:     return same_forward(get<Forward>(), other.get<Forward>());
+            default:                       return *this == other; // Equality already compares exactly the hashed fields
+        }
+        // @formatter:on
+    }
+
     Segment Segment::from_json(const detail::JsonElem json)
     {
         using namespace clu::literals;